@@ -1,3 +1,4 @@
+#include "../05.sources/AllocationTrace.h"
 #include <iostream>
 using namespace std;
 
@@ -50,8 +51,6 @@ struct Rectangle
 	}
 };
 
-int count_alloc = 0;
-
 // NOTE: A TEMPLATE!
 // Lets us generate structs based on a given type (one or more) which we choose
 // on object construction (we call this "template instantiation").
@@ -63,6 +62,43 @@ private:
 	T* array;
 	unsigned size;
 
+	// How many elements `array` has room for. Always `size <= allocated`.
+	unsigned allocated;
+
+	/*
+	 * Every new[] and delete[] goes through these two, so that the
+	 * allocations can be counted with -DTRACE_ALLOCATIONS (see
+	 * AllocationTrace.h). Without it they are plain new[] and delete[].
+	 */
+	static T* allocate(unsigned n)
+	{
+		T* p = new T[n];
+		traceAllocate<DynamicArray>(p, n * sizeof(T));
+		return p;
+	}
+
+	static void deallocate(T* p, unsigned n)
+	{
+		if (p) traceDeallocate<DynamicArray>(p, n * sizeof(T));
+		delete[] p;
+	}
+
+	/*
+	 * Moves the elements into a freshly allocated block with room for exactly
+	 * `newCapacity` elements.
+	 */
+	void reallocate(unsigned newCapacity)
+	{
+		T* resized = newCapacity ? allocate(newCapacity) : nullptr;
+
+		for (unsigned i = 0; i < size; ++i)
+			resized[i] = array[i];
+
+		deallocate(array, allocated);
+		array = resized;
+		allocated = newCapacity;
+	}
+
 public:
 	/*
 	 * Constructor - an automatically called function on object initialization.
@@ -71,82 +107,57 @@ public:
 	 *
 	 * @TODO. Proper initialization of the member fields
 	 */
-	DynamicArray(unsigned n) : array{new T[n]}, size{n}
-	{
-		cout << "Dynamic array allocated #" << (count_alloc++) << endl;
-	}
+	DynamicArray(unsigned n) : array{allocate(n)}, size{n}, allocated{n} {}
 
 	unsigned getSize() { return this->size; }
 
+	unsigned capacity() { return allocated; }
+
 	T& operator[](unsigned i) { return array[i]; }
 
+	// Makes room for at least `n` elements. Never shrinks.
+	void reserve(unsigned n)
+	{
+		if (n > allocated) reallocate(n);
+	}
+
+	// Releases the spare capacity.
+	void shrink_to_fit()
+	{
+		if (allocated > size) reallocate(size);
+	}
+
 	/*
-	 * Pushes an element at the end of the array, or rather creates a new array
-	 * from the old with one element more at the right end.
+	 * Pushes an element at the end of the array.
+	 * NOTE: When there is no spare room left, we double the capacity instead
+	 * of growing by one. This way n pushes cost O(n) copies in total.
 	 */
 	void push(const T& newElement)
 	{
-		// 1. Allocate memory for the updated array of size one more than
-		// this->array.
-		// @TODO think: how to optimize memory allocations when push() is called
-		// multiple times on the same instance.
-		T* extended = new T[size + 1];
-
-		// 2. Move everything from this->array to `extended`.
-		// Elements range from the 0th to (size - 1)th index.
-		for (int i = 0; i < size; ++i)
-			extended[i] = array[i];
-
-		// 3. Note that we didn't put anything in the last position of
-		// `extended` - `extended[size]` (remember, it's size is (size + 1)).
-		// We copy the element passed as an argument into the new array.
-		extended[size] = newElement;
-
-		// 4. NOTE: The old memory is currently referenced by the current value
-		// of this->array. We free the memory for the old array as it's not
-		// needed anymore.
-		delete[] array;
-
+		if (size == allocated) {
+			// NOTE: `newElement` may be an element of this very array (e.g.
+			// `a.push(a[0])`), which reallocate() frees. Copy it first.
+			T copy = newElement;
+			reallocate(allocated ? allocated * 2 : 4);
+			array[size] = copy;
+		} else {
+			array[size] = newElement;
+		}
 		size++;
-
-		// 5. Unless we execute the following line, this->array will point to
-		// the old memory block which we just released back to the operating
-		// system. We finish by reassigning `this->array` to point to the newly
-		// allocated `extended`.
-		array = extended;
-
-		// @TODO think: what would happen if we swap the last two actions?
 	}
 
 	/*
-	 * Removes the n'th element, or rather creates a new array from the old with
-	 * its n'th element removed.
+	 * Removes the n'th element by shifting the ones after it one place to the
+	 * left. No memory is allocated: the capacity stays, for the next push().
+	 * NOTE: The last slot keeps a stale copy of the last element - new[]
+	 * constructed every slot, so it stays a valid T until delete[].
 	 */
 	void deleteAt(unsigned n)
 	{
-		// Allocate memory for the shrunken array
-		T* shrunken = new T[size - 1];
-
-		// Copy everything from `array` into `shrunken`, except for the array[n]
-		// NOTE: Can be done with 2 `for` loops without conditional blocks.
-		for (unsigned i = 0; i < size; ++i) {
-			if (i < n) shrunken[i] = array[i];
-
-			if (i > n) shrunken[i - 1] = array[i];
-		}
-
-		// NOTE: The old memory is currently referenced by the current value of
-		// this->array. We free the memory for the old array as it's not needed
-		// anymore.
-		delete[] array;
+		for (unsigned i = n; i + 1 < size; ++i)
+			array[i] = array[i + 1];
 
 		size--;
-
-		// Unless we execute the following line, this->array will point to the
-		// old memory block which we just released back to the operating system.
-		// We finish by reassigning `this->array` to point to the newly
-		// allocated `extended`.
-		array = shrunken;
 	}
 
 	/*
@@ -155,12 +166,7 @@ public:
 	 *
 	 * An easy way not to forget to free whatever you allocated!
 	 */
-	~DynamicArray()
-	{
-		cout << "Before delete" << endl;
-		delete[] array;
-		cout << "After delete" << endl;
-	}
+	~DynamicArray() { deallocate(array, allocated); }
 };
 
 struct Window
@@ -1,39 +1,9 @@
 #include <iostream>
 using namespace std;
 
-template <typename T> class Matrix
-{
-private: // Note: private by default, no need to specify.
-	T** data;
-	unsigned cols, rows;
-
-public:
-	Matrix(unsigned rows, unsigned cols)
-	    // Init member fields. Note that cols{cols} works as expected - it
-	    // assigns the argument `cols` to `this->cols`.
-	    : data{new T*[rows]}, cols{cols}, rows{rows}
-	{
-		for (unsigned i = 0; i < rows; ++i) {
-			data[i] = new T[cols];
-		}
-	}
-
-	unsigned getRows() { return rows; }
-	unsigned getCols() { return cols; }
-
-	// NOTE: Return by reference!
-	T& get(int row, int col) { return data[row][col]; }
-
-	void set(int row, int col, T const& newValue) { data[row][col] = newValue; }
-
-	~Matrix()
-	{
-		for (unsigned i = 0; i < rows; ++i) {
-			delete[] data[i];
-		}
-		delete[] data;
-	}
-};
+// NOTE: The Matrix class itself now lives in a header, next to DynamicArray,
+// so that the simulation code can use it too.
+#include "../05.sources/Matrix.h"
 
 int main()
 {
@@ -43,4 +13,13 @@ int main()
 	matrix.get(2, 2) = 10; // .get() returned by reference, so we can assign!
 
 	cout << matrix.get(3, 3) << "; " << matrix.get(2, 2) << endl;
+
+	// The same, but from a pool of blocks of 5 x 5 ints. The cells of a
+	// matrix are one contiguous block, so each 5 x 5 matrix takes one block
+	// of the pool - and hands it back for the next one when it is freed.
+	Pool blocks{5 * 5 * sizeof(int)};
+	Matrix<int, PoolAllocator> pooled{5, 5, PoolAllocator{blocks}};
+	pooled.set(2, 3, 10);
+
+	cout << pooled.get(2, 3) << endl;
 }
@@ -0,0 +1,284 @@
+#pragma once
+
+#include <cstddef>
+
+/*
+ * Allocation tracing: how many allocations, bytes and reallocations each
+ * container type makes, and how much memory it holds at most ("peak live").
+ *
+ * It is compiled in only with -DTRACE_ALLOCATIONS. Otherwise every hook
+ * below is an empty inline function, and costs nothing.
+ *
+ * With tracing on, a summary is printed to stderr at exit:
+ *
+ *     g++ -DTRACE_ALLOCATIONS ... && ./simulation
+ *     allocations  reallocs  frees  bytes  peak live  container type
+ *     ...
+ *
+ * The allocations can also be grouped by the part of the program making
+ * them, with a tag which is active until the end of the scope:
+ *
+ *     void City::update(...)
+ *     {
+ *         AllocationTag tag{"City::update"};
+ *         ...
+ *     }
+ *
+ * NOTE: The containers call the hooks themselves - traceAllocate() etc.
+ * with their own type - wherever they get or release memory.
+ */
+
+#ifdef TRACE_ALLOCATIONS
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cxxabi.h>
+#include <mutex>
+#include <string>
+#include <typeinfo>
+#include <unordered_map>
+
+struct AllocationStats
+{
+	unsigned long long allocations = 0, reallocations = 0, deallocations = 0;
+	unsigned long long bytes = 0; // Allocated in total, including growth.
+	unsigned long long live = 0, peakLive = 0;
+
+	void allocated(size_t n)
+	{
+		allocations++;
+		bytes += n;
+		grow(n);
+	}
+
+	void deallocated(size_t n)
+	{
+		deallocations++;
+		live -= n;
+	}
+
+	void reallocated(size_t oldBytes, size_t newBytes)
+	{
+		reallocations++;
+		if (newBytes > oldBytes) bytes += newBytes - oldBytes;
+		live -= oldBytes;
+		grow(newBytes);
+	}
+
+	void grow(size_t n)
+	{
+		live += n;
+		if (live > peakLive) peakLive = live;
+	}
+};
+
+/*
+ * The counters of the whole program.
+ *
+ * NOTE: Every record takes a mutex - tracing is for finding hot spots, not
+ * for production speed. Its own bookkeeping uses the standard containers,
+ * which are not traced.
+ */
+class AllocationTrace
+{
+	std::mutex mutex;
+
+	// Keyed by name: container types, and tags.
+	using Table = std::unordered_map<std::string, AllocationStats>;
+	Table byType, byTag;
+
+	// Which tag each live block was allocated under, so that its release is
+	// counted there too.
+	struct Block
+	{
+		AllocationStats* tag;
+		size_t bytes;
+	};
+	std::unordered_map<void const*, Block> blocks;
+
+	static const char*& currentTagSlot()
+	{
+		thread_local const char* tag = "(untagged)";
+		return tag;
+	}
+
+	static void print(std::FILE* out, const char* title, Table const& map)
+	{
+		std::fprintf(out, "%12s %10s %10s %14s %14s  %s\n", "allocations",
+		             "reallocs", "frees", "bytes", "peak live", title);
+		for (auto const& entry : map) {
+			AllocationStats const& s = entry.second;
+			std::fprintf(out, "%12llu %10llu %10llu %14llu %14llu  %s\n",
+			             s.allocations, s.reallocations, s.deallocations,
+			             s.bytes, s.peakLive, entry.first.c_str());
+		}
+	}
+
+	AllocationTrace()
+	{
+		std::atexit([] { instance().print(stderr); });
+	}
+
+public:
+	// NOTE: Never destroyed, so that containers destroyed after the summary
+	// (e.g. globals) can still record safely.
+	static AllocationTrace& instance()
+	{
+		static AllocationTrace* trace = new AllocationTrace;
+		return *trace;
+	}
+
+	static const char* currentTag() { return currentTagSlot(); }
+	static void setCurrentTag(const char* tag) { currentTagSlot() = tag; }
+
+	void allocated(const char* type, void const* p, size_t bytes)
+	{
+		std::lock_guard<std::mutex> lock{mutex};
+		AllocationStats& tag = byTag[currentTag()];
+		byType[type].allocated(bytes);
+		tag.allocated(bytes);
+		blocks[p] = Block{&tag, bytes};
+	}
+
+	void deallocated(const char* type, void const* p, size_t bytes)
+	{
+		std::lock_guard<std::mutex> lock{mutex};
+		byType[type].deallocated(bytes);
+
+		auto block = blocks.find(p);
+		if (block == blocks.end()) return; // Allocated before tracing began.
+		block->second.tag->deallocated(bytes);
+		blocks.erase(block);
+	}
+
+	/*
+	 * A reallocation is recorded in two steps, as the old block can't be
+	 * looked up once it is freed: reallocating() before, which forgets the
+	 * old block and returns its tag, and reallocated() after, with the new
+	 * block. The block stays with the tag it was first allocated under.
+	 */
+	AllocationStats* reallocating(void const* oldP)
+	{
+		std::lock_guard<std::mutex> lock{mutex};
+		auto block = blocks.find(oldP);
+		if (block == blocks.end()) return &byTag[currentTag()];
+
+		AllocationStats* tag = block->second.tag;
+		blocks.erase(block);
+		return tag;
+	}
+
+	void reallocated(const char* type, AllocationStats* tag, void const* newP,
+	                 size_t oldBytes, size_t newBytes)
+	{
+		std::lock_guard<std::mutex> lock{mutex};
+		byType[type].reallocated(oldBytes, newBytes);
+		tag->reallocated(oldBytes, newBytes);
+		blocks[newP] = Block{tag, newBytes};
+	}
+
+	void print(std::FILE* out)
+	{
+		std::lock_guard<std::mutex> lock{mutex};
+		std::fprintf(out, "\n--- Allocations by container type ---\n");
+		print(out, "container type", byType);
+		std::fprintf(out, "--- Allocations by tag ---\n");
+		print(out, "tag", byTag);
+	}
+};
+
+// The readable name of a type, e.g. "DynamicArray<Person, MallocAllocator>".
+// NOTE: Never freed, like the trace itself.
+template <typename T> const char* tracedTypeName()
+{
+	static const char* name = [] {
+		int status = 0;
+		char* demangled =
+		    abi::__cxa_demangle(typeid(T).name(), nullptr, nullptr, &status);
+		return status == 0 ? demangled : typeid(T).name();
+	}();
+	return name;
+}
+
+/*
+ * Groups the allocations made by this thread, until the end of the scope,
+ * under `name` (a string literal, or a string which outlives the program).
+ * Tags can be nested; the innermost one wins.
+ */
+class AllocationTag
+{
+	const char* previous;
+
+public:
+	explicit AllocationTag(const char* name)
+	    : previous{AllocationTrace::currentTag()}
+	{
+		AllocationTrace::setCurrentTag(name);
+	}
+
+	AllocationTag(AllocationTag const&) = delete;
+	AllocationTag& operator=(AllocationTag const&) = delete;
+
+	~AllocationTag() { AllocationTrace::setCurrentTag(previous); }
+};
+
+template <typename Container>
+inline void traceAllocate(void const* p, size_t bytes)
+{
+	AllocationTrace::instance().allocated(tracedTypeName<Container>(), p,
+	                                      bytes);
+}
+
+template <typename Container>
+inline void traceDeallocate(void const* p, size_t bytes)
+{
+	AllocationTrace::instance().deallocated(tracedTypeName<Container>(), p,
+	                                        bytes);
+}
+
+// Call with the old block *before* reallocating it, and pass the result on
+// to traceReallocate() - see AllocationTrace::reallocating().
+template <typename Container>
+inline AllocationStats* traceReallocating(void const* oldP)
+{
+	return AllocationTrace::instance().reallocating(oldP);
+}
+
+template <typename Container>
+inline void traceReallocate(AllocationStats* tag, void const* newP,
+                            size_t oldBytes, size_t newBytes)
+{
+	AllocationTrace::instance().reallocated(tracedTypeName<Container>(), tag,
+	                                        newP, oldBytes, newBytes);
+}
+
+#else // Tracing off: nothing at all.
+
+struct AllocationStats;
+
+class AllocationTag
+{
+public:
+	explicit AllocationTag(const char*) {}
+};
+
+template <typename Container> inline void traceAllocate(void const*, size_t) {}
+
+template <typename Container>
+inline void traceDeallocate(void const*, size_t)
+{
+}
+
+template <typename Container>
+inline AllocationStats* traceReallocating(void const*)
+{
+	return nullptr;
+}
+
+template <typename Container>
+inline void traceReallocate(AllocationStats*, void const*, size_t, size_t)
+{
+}
+
+#endif
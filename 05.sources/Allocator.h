@@ -0,0 +1,356 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+/*
+ * Allocators hand out raw memory to DynamicArray and Matrix. Each of them
+ * provides the same three methods:
+ *
+ *     void* allocate(size_t bytes, size_t alignment);
+ *     void deallocate(void* p, size_t bytes);
+ *     void* reallocate(void* p, size_t oldBytes, size_t newBytes,
+ *                      size_t alignment);
+ *
+ * reallocate() is only used for trivially copyable elements, so it may move
+ * the bytes with memcpy. None of them constructs or destroys objects - that
+ * is left to the containers.
+ *
+ * NOTE: The allocators are *small handles* - copying one gives another handle
+ * to the same memory source (e.g. the same Arena). Containers keep a copy.
+ */
+
+// Rounds `n` up to a multiple of `alignment` (a power of two).
+inline size_t alignUp(size_t n, size_t alignment)
+{
+	return (n + alignment - 1) & ~(alignment - 1);
+}
+
+/*
+ * The default: plain malloc/realloc/free from the C library.
+ */
+struct MallocAllocator
+{
+	void* allocate(size_t bytes, size_t alignment)
+	{
+		void* memory = alignment <= alignof(std::max_align_t)
+		                   ? std::malloc(bytes)
+		                   : std::aligned_alloc(alignment,
+		                                        alignUp(bytes, alignment));
+		if (!memory) throw std::bad_alloc();
+		return memory;
+	}
+
+	void deallocate(void* p, size_t) { std::free(p); }
+
+	void* reallocate(void* p, size_t oldBytes, size_t newBytes,
+	                 size_t alignment)
+	{
+		// realloc() only guarantees malloc()'s alignment.
+		if (alignment > alignof(std::max_align_t)) {
+			void* memory = allocate(newBytes, alignment);
+			if (p)
+				std::memcpy(memory, p,
+				            oldBytes < newBytes ? oldBytes : newBytes);
+			std::free(p);
+			return memory;
+		}
+
+		void* memory = std::realloc(p, newBytes);
+		if (!memory) throw std::bad_alloc();
+		return memory;
+	}
+};
+
+/*
+ * A monotonic ("bump pointer") memory region. Allocating is just moving a
+ * pointer forward; individual blocks are never freed. Instead, everything is
+ * released at once with reset() - e.g. at the end of a simulation frame.
+ *
+ * The memory comes in chunks of `chunkSize` bytes (or more, for bigger
+ * requests), which are kept and reused after reset().
+ *
+ * NOTE: Every container using the arena must be destroyed (or never used
+ * again) before reset(). Not thread-safe - use one arena per thread.
+ */
+class Arena
+{
+	struct Chunk
+	{
+		Chunk* next;
+		size_t capacity; // bytes after the header
+	};
+
+	Chunk* chunks;  // The chunk we allocate from, then the full ones.
+	Chunk* spare;   // Chunks freed by reset(), ready to be reused.
+	char* current;  // Next free byte in `chunks`.
+	char* end;      // One past the last byte of `chunks`.
+	char* last;     // The most recent allocation, which we can still resize.
+	size_t chunkSize;
+
+	static char* begin(Chunk* chunk)
+	{
+		return reinterpret_cast<char*>(chunk) + alignUp(sizeof(Chunk), 64);
+	}
+
+	void addChunk(size_t minBytes)
+	{
+		Chunk* chunk = nullptr;
+		if (spare && spare->capacity >= minBytes) {
+			chunk = spare;
+			spare = spare->next;
+		} else {
+			size_t capacity = minBytes > chunkSize ? minBytes : chunkSize;
+			void* memory = std::malloc(alignUp(sizeof(Chunk), 64) + capacity);
+			if (!memory) throw std::bad_alloc();
+			chunk = static_cast<Chunk*>(memory);
+			chunk->capacity = capacity;
+		}
+
+		chunk->next = chunks;
+		chunks = chunk;
+		current = begin(chunk);
+		end = current + chunk->capacity;
+	}
+
+	static void freeChunks(Chunk* chunk)
+	{
+		while (chunk) {
+			Chunk* next = chunk->next;
+			std::free(chunk);
+			chunk = next;
+		}
+	}
+
+public:
+	explicit Arena(size_t chunkSize = 1 << 20)
+	    : chunks{nullptr}, spare{nullptr}, current{nullptr}, end{nullptr},
+	      last{nullptr}, chunkSize{chunkSize}
+	{
+	}
+
+	Arena(Arena const&) = delete;
+	Arena& operator=(Arena const&) = delete;
+
+	void* allocate(size_t bytes, size_t alignment)
+	{
+		char* p = current ? reinterpret_cast<char*>(alignUp(
+		                        reinterpret_cast<size_t>(current), alignment))
+		                  : nullptr;
+
+		if (!p || p + bytes > end) {
+			addChunk(bytes + alignment);
+			p = reinterpret_cast<char*>(
+			    alignUp(reinterpret_cast<size_t>(current), alignment));
+		}
+
+		current = p + bytes;
+		last = p;
+		return p;
+	}
+
+	// Individual blocks are not freed; only the most recent one is given
+	// back, so that a push-pop pattern doesn't eat up the arena.
+	void deallocate(void* p, size_t)
+	{
+		if (p && p == last) {
+			current = last;
+			last = nullptr;
+		}
+	}
+
+	void* reallocate(void* p, size_t oldBytes, size_t newBytes,
+	                 size_t alignment)
+	{
+		// Growing the most recent block is free if the chunk has room.
+		if (p && p == last && last + newBytes <= end) {
+			current = last + newBytes;
+			return p;
+		}
+
+		void* memory = allocate(newBytes, alignment);
+		if (p)
+			std::memcpy(memory, p, oldBytes < newBytes ? oldBytes : newBytes);
+		return memory;
+	}
+
+	/*
+	 * Releases everything allocated so far, in O(number of chunks). The
+	 * chunks are kept for reuse, so a steady state frame loop stops calling
+	 * malloc() altogether.
+	 */
+	void reset()
+	{
+		while (chunks) {
+			Chunk* next = chunks->next;
+			chunks->next = spare;
+			spare = chunks;
+			chunks = next;
+		}
+		current = end = last = nullptr;
+	}
+
+	// Returns all the memory to the system.
+	~Arena()
+	{
+		freeChunks(chunks);
+		freeChunks(spare);
+	}
+};
+
+// Allocates from an Arena. E.g.
+//     Arena frame;
+//     DynamicArray<Position, ArenaAllocator> positions{ArenaAllocator{frame}};
+struct ArenaAllocator
+{
+	Arena* arena;
+
+	explicit ArenaAllocator(Arena& arena) : arena{&arena} {}
+
+	void* allocate(size_t bytes, size_t alignment)
+	{
+		return arena->allocate(bytes, alignment);
+	}
+
+	void deallocate(void* p, size_t bytes) { arena->deallocate(p, bytes); }
+
+	void* reallocate(void* p, size_t oldBytes, size_t newBytes,
+	                 size_t alignment)
+	{
+		return arena->reallocate(p, oldBytes, newBytes, alignment);
+	}
+};
+
+/*
+ * A pool of equally sized blocks. Freed blocks are kept in a linked list
+ * (the "free list") and handed out again, so allocating and freeing are a
+ * couple of pointer operations and the memory never fragments.
+ *
+ * Good for many objects of the same size, e.g. the rows of equally sized
+ * matrices. Requests bigger than `blockSize` go to malloc().
+ *
+ * NOTE: Not thread-safe - use one pool per thread.
+ * NOTE: The blocks are aligned for any ordinary type (max_align_t), and
+ * over-aligned requests throw std::bad_alloc: deallocate() only gets the
+ * size, so it couldn't tell a small over-aligned block (which would have to
+ * come from aligned_alloc()) from one of the pool's own.
+ */
+class Pool
+{
+	union Block
+	{
+		Block* next;
+	};
+
+	struct Slab
+	{
+		Slab* next;
+	};
+
+	Block* freeList;
+	Slab* slabs;
+	size_t blockSize;
+	size_t blocksPerSlab;
+
+	void addSlab()
+	{
+		size_t header = alignUp(sizeof(Slab), 64);
+		void* memory = std::malloc(header + blockSize * blocksPerSlab);
+		if (!memory) throw std::bad_alloc();
+
+		Slab* slab = static_cast<Slab*>(memory);
+		slab->next = slabs;
+		slabs = slab;
+
+		char* first = static_cast<char*>(memory) + header;
+		for (size_t i = blocksPerSlab; i-- > 0;) {
+			Block* block = reinterpret_cast<Block*>(first + i * blockSize);
+			block->next = freeList;
+			freeList = block;
+		}
+	}
+
+public:
+	Pool(size_t blockSize, size_t blocksPerSlab = 256)
+	    : freeList{nullptr}, slabs{nullptr},
+	      blockSize{alignUp(blockSize < sizeof(Block) ? sizeof(Block)
+	                                                  : blockSize,
+	                        alignof(std::max_align_t))},
+	      blocksPerSlab{blocksPerSlab}
+	{
+	}
+
+	Pool(Pool const&) = delete;
+	Pool& operator=(Pool const&) = delete;
+
+	size_t getBlockSize() const { return blockSize; }
+
+	void* allocate(size_t bytes, size_t alignment)
+	{
+		if (alignment > alignof(std::max_align_t)) throw std::bad_alloc();
+		if (bytes > blockSize)
+			return MallocAllocator{}.allocate(bytes, alignment);
+
+		if (!freeList) addSlab();
+
+		Block* block = freeList;
+		freeList = block->next;
+		return block;
+	}
+
+	void deallocate(void* p, size_t bytes)
+	{
+		if (!p) return;
+		if (bytes > blockSize) return std::free(p);
+
+		Block* block = static_cast<Block*>(p);
+		block->next = freeList;
+		freeList = block;
+	}
+
+	void* reallocate(void* p, size_t oldBytes, size_t newBytes,
+	                 size_t alignment)
+	{
+		// Still fits in the same block - nothing to do.
+		if (p && oldBytes <= blockSize && newBytes <= blockSize) return p;
+
+		void* memory = allocate(newBytes, alignment);
+		if (p) {
+			std::memcpy(memory, p, oldBytes < newBytes ? oldBytes : newBytes);
+			deallocate(p, oldBytes);
+		}
+		return memory;
+	}
+
+	~Pool()
+	{
+		while (slabs) {
+			Slab* next = slabs->next;
+			std::free(slabs);
+			slabs = next;
+		}
+	}
+};
+
+// Allocates from a Pool.
+struct PoolAllocator
+{
+	Pool* pool;
+
+	explicit PoolAllocator(Pool& pool) : pool{&pool} {}
+
+	void* allocate(size_t bytes, size_t alignment)
+	{
+		return pool->allocate(bytes, alignment);
+	}
+
+	void deallocate(void* p, size_t bytes) { pool->deallocate(p, bytes); }
+
+	void* reallocate(void* p, size_t oldBytes, size_t newBytes,
+	                 size_t alignment)
+	{
+		return pool->reallocate(p, oldBytes, newBytes, alignment);
+	}
+};
@@ -0,0 +1,243 @@
+#pragma once
+
+#include "DynamicArray.h"
+#include "ThreadPool.h"
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+/*
+ * Lazy views: map, filter and zip over a DynamicArray, without intermediate
+ * arrays.
+ *
+ *     DynamicArray<Position> sickOutside =
+ *         view(city.people)
+ *             .filter([](Person& p) {
+ *                 return !p.loc.checkIfHome() && !p.healthState.isHealthy();
+ *             })
+ *             .map([](Person& p) { return p.loc.getPosition(); })
+ *             .toDynamicArray();
+ *
+ * Like the matrix expressions (see MatrixExpression.h), map() and filter()
+ * compute nothing - they build a small object whose type describes the
+ * pipeline. The work happens in toDynamicArray() (or forEach(), count()),
+ * in a single pass: each element goes through the whole pipeline before the
+ * next one is read, and only the final result is stored.
+ *
+ * Every view can be walked with forEach(f). Views where element i can be
+ * computed directly - the array itself, map() and zip() of such views - are
+ * also "random access": they have getSize() and at(i), so they can be split
+ * over threads with parallelMap(). A filter() is not - we can't know where
+ * its i'th element is without checking all the ones before.
+ *
+ * NOTE: A view keeps a reference to the array - don't let it outlive it.
+ */
+
+// The base of every view. `V` is the actual type (CRTP, like
+// MatrixExpression).
+template <typename V> struct ArrayView;
+
+// Every element of `source`, passed through `f`.
+template <typename V, typename F> struct Mapped;
+
+// Only the elements of `source` for which `pred` is true.
+template <typename V, typename Pred> struct Filtered;
+
+template <typename V> struct ArrayView
+{
+	V const& self() const { return static_cast<V const&>(*this); }
+
+	template <typename F> Mapped<V, F> map(F f) const
+	{
+		return {self(), std::move(f)};
+	}
+
+	template <typename Pred> Filtered<V, Pred> filter(Pred pred) const
+	{
+		return {self(), std::move(pred)};
+	}
+
+	// Stores the elements of the view in a new array.
+	auto toDynamicArray() const
+	{
+		DynamicArray<typename V::Value> result;
+		if constexpr (V::isRandomAccess) result.reserve(self().getSize());
+
+		self().forEach([&](auto&& x) {
+			result.push(std::forward<decltype(x)>(x));
+		});
+		return result;
+	}
+
+	// The number of elements, e.g. of sick people.
+	unsigned count() const
+	{
+		if constexpr (V::isRandomAccess) {
+			return self().getSize();
+		} else {
+			unsigned n = 0;
+			self().forEach([&](auto&&) { n++; });
+			return n;
+		}
+	}
+};
+
+// All elements of a DynamicArray, by reference. `Array` may be const.
+template <typename Array> struct ArraySource : ArrayView<ArraySource<Array>>
+{
+	using Reference = decltype(std::declval<Array&>()[0]);
+	using Value = typename std::decay<Reference>::type;
+	static constexpr bool isRandomAccess = true;
+
+	Array& array;
+
+	ArraySource(Array& array) : array(array) {}
+
+	unsigned getSize() const { return array.getSize(); }
+	Reference at(unsigned i) const { return array[i]; }
+
+	template <typename F> void forEach(F const& f) const
+	{
+		for (unsigned i = 0; i < array.getSize(); ++i)
+			f(array[i]);
+	}
+};
+
+template <typename V, typename F> struct Mapped : ArrayView<Mapped<V, F>>
+{
+	using Reference = decltype(
+	    std::declval<F const&>()(std::declval<typename V::Reference>()));
+	using Value = typename std::decay<Reference>::type;
+	static constexpr bool isRandomAccess = V::isRandomAccess;
+
+	V source;
+	F f;
+
+	Mapped(V const& source, F f) : source(source), f(std::move(f)) {}
+
+	unsigned getSize() const { return source.getSize(); }
+	Reference at(unsigned i) const { return f(source.at(i)); }
+
+	template <typename G> void forEach(G const& g) const
+	{
+		source.forEach([&](auto&& x) { g(f(std::forward<decltype(x)>(x))); });
+	}
+};
+
+template <typename V, typename Pred>
+struct Filtered : ArrayView<Filtered<V, Pred>>
+{
+	using Reference = typename V::Reference;
+	using Value = typename V::Value;
+	static constexpr bool isRandomAccess = false;
+
+	V source;
+	Pred pred;
+
+	Filtered(V const& source, Pred pred) : source(source), pred(std::move(pred))
+	{
+	}
+
+	template <typename G> void forEach(G const& g) const
+	{
+		source.forEach([&](auto&& x) {
+			if (pred(x)) g(std::forward<decltype(x)>(x));
+		});
+	}
+};
+
+// Pairs of elements of `a` and `b` with the same index.
+template <typename A, typename B> struct Zipped : ArrayView<Zipped<A, B>>
+{
+	using Reference =
+	    std::pair<typename A::Reference, typename B::Reference>;
+	using Value = std::pair<typename A::Value, typename B::Value>;
+	static constexpr bool isRandomAccess = true;
+
+	A a;
+	B b;
+
+	Zipped(A const& a, B const& b) : a(a), b(b)
+	{
+		static_assert(A::isRandomAccess && B::isRandomAccess,
+		              "Can't zip a filter() - its elements have no index");
+		if (a.getSize() != b.getSize())
+			throw std::runtime_error("The arrays must be of the same size");
+	}
+
+	unsigned getSize() const { return a.getSize(); }
+	Reference at(unsigned i) const { return Reference(a.at(i), b.at(i)); }
+
+	template <typename G> void forEach(G const& g) const
+	{
+		for (unsigned i = 0; i < getSize(); ++i)
+			g(at(i));
+	}
+};
+
+// A view of all elements of `array`, the start of every pipeline.
+template <typename T, typename A>
+ArraySource<DynamicArray<T, A>> view(DynamicArray<T, A>& array)
+{
+	return {array};
+}
+
+template <typename T, typename A>
+ArraySource<DynamicArray<T, A> const> view(DynamicArray<T, A> const& array)
+{
+	return {array};
+}
+
+template <typename A, typename B>
+Zipped<A, B> zip(ArrayView<A> const& a, ArrayView<B> const& b)
+{
+	return {a.self(), b.self()};
+}
+
+template <typename T1, typename A1, typename T2, typename A2>
+auto zip(DynamicArray<T1, A1>& a, DynamicArray<T2, A2>& b)
+{
+	return zip(view(a), view(b));
+}
+
+/*
+ * The same as `v.map(f).toDynamicArray()`, with the elements split in
+ * blocks of `grain` over the pool. Worth it when `f` is expensive; for a
+ * cheap `f` the single pass of toDynamicArray() is limited by memory anyway.
+ *
+ * NOTE: `f` is called concurrently, so it must not modify shared state,
+ * and must not throw (see ThreadPool). The result has the same order (and
+ * the same values) as the serial one.
+ */
+template <typename V, typename F>
+auto parallelMap(ArrayView<V> const& v, F const& f, ThreadPool& pool,
+                 unsigned grain = 1024)
+{
+	static_assert(V::isRandomAccess,
+	              "Can't split a filter() - its elements have no index");
+
+	V const& source = v.self();
+	using Value = typename std::decay<decltype(f(source.at(0)))>::type;
+
+	// Each result is constructed right in its place: no default-constructed
+	// Value to assign over (Person has none), and one pass over the memory.
+	unsigned size = source.getSize();
+	DynamicArray<Value> result;
+	result.appendInPlace(size, [&](Value* raw) {
+		pool.parallelFor((size + grain - 1) / grain, [&](unsigned block) {
+			unsigned begin = block * grain;
+			unsigned end = size - begin < grain ? size : begin + grain;
+			for (unsigned i = begin; i < end; ++i)
+				new (raw + i) Value(f(source.at(i)));
+		});
+	});
+	return result;
+}
+
+template <typename T, typename A, typename F>
+auto parallelMap(DynamicArray<T, A> const& array, F const& f, ThreadPool& pool,
+                 unsigned grain = 1024)
+{
+	return parallelMap(view(array), f, pool, grain);
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "DynamicArray.h"
+#include <condition_variable>
+#include <mutex>
+#include <utility>
+
+/*
+ * A queue of at most `capacity` elements between threads, e.g. from a
+ * thread which must never wait to one which does the slow work:
+ *
+ *     BoundedQueue<Frame> queue{16};
+ *     queue.tryPush(std::move(frame));  // false if full - never waits
+ *     ...
+ *     while (queue.pop(frame)) write(frame); // waits; false once closed
+ *
+ * The elements are moved in and out of a ring of slots allocated once.
+ * NOTE: The lock is only held to move an element, so tryPush() is fast -
+ * but not lock-free, unlike ConcurrentArray.
+ */
+template <typename T> class BoundedQueue
+{
+	DynamicArray<T> slots;
+	unsigned first = 0; // The slot of the oldest element.
+	unsigned size = 0;
+	bool closed = false;
+
+	std::mutex mutex;
+	std::condition_variable notEmpty; // An element, or closed.
+
+public:
+	explicit BoundedQueue(unsigned capacity) : slots(capacity ? capacity : 1)
+	{
+	}
+
+	BoundedQueue(BoundedQueue const&) = delete;
+	BoundedQueue& operator=(BoundedQueue const&) = delete;
+
+	// Adds `value` unless the queue is full or closed; never waits.
+	bool tryPush(T&& value)
+	{
+		{
+			std::lock_guard<std::mutex> lock{mutex};
+			if (closed || size == slots.getSize()) return false;
+
+			slots[(first + size) % slots.getSize()] = std::move(value);
+			size++;
+		}
+		notEmpty.notify_one();
+		return true;
+	}
+
+	// Takes the oldest element, if there is one; never waits.
+	bool tryPop(T& value)
+	{
+		std::lock_guard<std::mutex> lock{mutex};
+		if (size == 0) return false;
+
+		value = std::move(slots[first]);
+		first = (first + 1) % slots.getSize();
+		size--;
+		return true;
+	}
+
+	/*
+	 * Takes the oldest element, waiting for one if the queue is empty.
+	 * Returns false once the queue is closed and empty.
+	 */
+	bool pop(T& value)
+	{
+		std::unique_lock<std::mutex> lock{mutex};
+		notEmpty.wait(lock, [&] { return size > 0 || closed; });
+		if (size == 0) return false;
+
+		value = std::move(slots[first]);
+		first = (first + 1) % slots.getSize();
+		size--;
+		return true;
+	}
+
+	// No more pushes; pop() takes what is left, then returns false.
+	void close()
+	{
+		{
+			std::lock_guard<std::mutex> lock{mutex};
+			closed = true;
+		}
+		notEmpty.notify_all();
+	}
+};
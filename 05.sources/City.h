@@ -2,29 +2,172 @@
 #include "DynamicArray.h"
 #include "Position.h"
 #include "Person.h"
+#include "Random.h"
+#include "SmallDynamicArray.h"
+#include "SpatialGrid.h"
+#include "ThreadPool.h"
+#include "TimingWheel.h"
+#include <new>
+#include <utility>
 
+/*
+ * NOTE: update() is "double-buffered": it computes the state after the tick
+ * (`next`) only from the state before it (`people`, the grid), and then
+ * swaps the two. Each person changes only their own copy in `next`, and
+ * takes their random numbers from their own stream - a hash of (seed, tick,
+ * index). So nothing depends on the order in which people are updated,
+ * and a tick gives bit-identical results on any number of threads.
+ *
+ * NOTE: The health transitions (symptoms, recovery) are events of a
+ * TimingWheel: a tick only looks at the people whose health changes, not
+ * at everybody. An event is just "look at person i at time t" - it fires
+ * if their HealthState::nextChange is still t - so an event of someone who
+ * has moved to another index (see World) is harmlessly skipped; whoever
+ * moves them schedules them anew with scheduleHealth().
+ */
 struct City
 {
 	DynamicArray<Person> people;
 
-	void update(unsigned deltaTime)
+	// The same seed and people give the same run.
+	unsigned long long seed = 0;
+	unsigned long long tick = 0; // The number of update()s so far.
+	unsigned time = 0;           // The sum of their deltaTimes.
+
+	// Where update() runs; null runs it on the calling thread.
+	ThreadPool* pool = nullptr;
+
+	// People per task of the pool. Big enough to amortize the scheduling,
+	// small enough to balance the load.
+	static constexpr unsigned UPDATE_BLOCK = 1024;
+
+	// The positions of the people who are outside and ill, as of the last
+	// rebuildIndex(). Cells of about the radius of infection.
+	SpatialGrid sickOutside{10};
+
+	// The indices of the people with a health transition ahead, by its time.
+	TimingWheel<unsigned> healthChanges{32};
+
+	/*
+	 * Puts the sick people who are outside in the grid. update() calls it at
+	 * the start of every tick; call it after changing `people` by hand.
+	 * O(people).
+	 */
+	void rebuildIndex()
 	{
+		sickOutside.clear();
 		for (unsigned i = 0; i < people.getSize(); ++i) {
-			people[i].update(deltaTime);
+			if (people[i].loc.checkIfHome()) continue;
+			if (people[i].healthState.healthState != HealthState::ILL)
+				continue;
+
+			sickOutside.add(people[i].loc.getPosition());
 		}
+		sickOutside.build();
 	}
 
-	bool hasSickPeopleAround(Position const& pos, float radius)
+	// Schedules the next health transition of person i, if they are ill.
+	void scheduleHealth(unsigned i)
 	{
-		for (unsigned i = 0; i < people.getSize(); ++i) {
-			if (people[i].loc.checkIfHome()) continue;
-			if (people[i].healthState.isHealthy()) continue;
+		HealthState const& health = people[i].healthState;
+		if (health.healthState == HealthState::ILL)
+			healthChanges.schedule(health.nextChange, i);
+	}
 
-			Position otherPos = people[i].loc.getPosition();
+	/*
+	 * Schedules the health transitions of everybody anew, from `time` on.
+	 * Call it after changing `people` by hand, like rebuildIndex() - but
+	 * update() doesn't: it keeps the schedule up to date itself. O(people).
+	 */
+	void rescheduleHealth()
+	{
+		healthChanges.clear(time);
+		for (unsigned i = 0; i < people.getSize(); ++i)
+			scheduleHealth(i);
+	}
 
-			if (withinRadius(pos, otherPos, radius)) return true;
+	void update(unsigned deltaTime)
+	{
+		time += deltaTime;
+		healthChanges.advanceTo(time, [&](unsigned due, unsigned i) {
+			if (i >= people.getSize()) return;
+			HealthState& health = people[i].healthState;
+			if (health.healthState != HealthState::ILL) return;
+			if (health.nextChange != due) return;
+
+			health.advance();
+			scheduleHealth(i);
+		});
+
+		rebuildIndex();
+
+		// NOTE: Grows or shrinks `next` to the size of `people`, instead of
+		// copying it, so a city whose population changes (see World) keeps
+		// its memory.
+		unsigned count = people.getSize();
+		while (next.getSize() < count)
+			next.push(people[next.getSize()]);
+		next.deleteRange(count, next.getSize() - count);
+
+		unsigned blocks = (count + UPDATE_BLOCK - 1) / UPDATE_BLOCK;
+		while (infected.getSize() < blocks)
+			infected.push(Infected{});
+
+		auto block = [&](unsigned b) {
+			unsigned begin = b * UPDATE_BLOCK;
+			unsigned end = begin + UPDATE_BLOCK < count ? begin + UPDATE_BLOCK
+			                                            : count;
+			for (unsigned i = begin; i < end; ++i) {
+				// NOTE: A Person can't be assigned (it holds a City&), so
+				// the copy is constructed in place, as in Elements.
+				next[i].~Person();
+				new (&next[i]) Person(people[i]);
+
+				RandomStream random{seed, (tick << 32) | i};
+				next[i].update(random);
+
+				if (people[i].healthState.isHealthy() &&
+				    !next[i].healthState.isHealthy())
+					infected[b].push(i);
+			}
+		};
+
+		if (pool)
+			pool->parallelFor(blocks, block);
+		else
+			for (unsigned b = 0; b < blocks; ++b)
+				block(b);
+
+		std::swap(people, next);
+
+		// In the order of the blocks, so the same on any number of threads.
+		for (unsigned b = 0; b < blocks; ++b) {
+			for (unsigned k = 0; k < infected[b].getSize(); ++k)
+				scheduleHealth(infected[b][k]);
+			infected[b].deleteRange(0, infected[b].getSize());
 		}
+		tick++;
+	}
 
-		return false;
+	/*
+	 * NOTE: Answers from the grid - i.e. where the sick people were at the
+	 * start of the tick, not after the moves made so far in this tick. So
+	 * the result doesn't depend on the order in which people are updated.
+	 * Only the cells around `pos` are checked, instead of every person.
+	 */
+	bool hasSickPeopleAround(Position const& pos, float radius)
+	{
+		return sickOutside.anyWithin(pos, radius);
 	}
+
+private:
+	// The state after the tick, while update() computes it.
+	DynamicArray<Person> next;
+
+	// The people infected in the tick, by block of update(). Each block
+	// writes only its own array. A block rarely infects more than a few
+	// people in a tick, so they fit inline: reading them back is a walk
+	// over `infected` rather than a heap block per block of people.
+	using Infected = SmallDynamicArray<unsigned, 8>;
+	DynamicArray<Infected> infected;
 };
@@ -0,0 +1,175 @@
+#pragma once
+
+#include "AllocationTrace.h"
+#include "Allocator.h"
+#include <atomic>
+#include <new>
+#include <utility>
+
+/*
+ * An append-only array which many threads can push() to at the same time,
+ * without locks - e.g. worker threads generating new agents or events.
+ *
+ *     ConcurrentArray<Event> events;
+ *     pool.parallelFor(n, [&](unsigned i) { events.push(simulate(i)); });
+ *     for (unsigned i = 0; i < events.getSize(); ++i) use(events[i]);
+ *
+ * Unlike DynamicArray, the elements live in fixed-size chunks which are
+ * never moved: growing just adds a chunk. So
+ *  - push() only reserves an index with one atomic increment; a new chunk is
+ *    allocated once per CHUNK_SIZE elements;
+ *  - the address of an element never changes, even while others push.
+ *
+ * Element i is in chunk i / CHUNK_SIZE. The chunk pointers are kept in pages
+ * of PAGE_SIZE, and the pages in a fixed table, so operator[] is two loads
+ * and no locks.
+ *
+ * NOTE: push() returns the index of the new element, which the pushing
+ * thread may use right away. The other threads may read it once they
+ * synchronize with the pushing thread - e.g. after parallelFor() returns,
+ * or after joining it. Reading an element while it is being pushed is a
+ * data race, just like with any other array.
+ * NOTE: There is no removal; the array is destroyed as a whole, by a single
+ * thread.
+ * NOTE: The constructor of T must not throw: the index of an element is
+ * reserved before it is constructed, and can't be given back.
+ */
+template <typename T> class ConcurrentArray
+{
+public:
+	static constexpr unsigned CHUNK_BITS = 12, PAGE_BITS = 10;
+	static constexpr unsigned CHUNK_SIZE = 1u << CHUNK_BITS;
+	static constexpr unsigned PAGE_SIZE = 1u << PAGE_BITS;
+
+private:
+	// Enough pages for every unsigned index.
+	static constexpr unsigned PAGES = 1u << (32 - CHUNK_BITS - PAGE_BITS);
+
+	using Page = std::atomic<T*>; // An array of PAGE_SIZE chunk pointers.
+
+	std::atomic<Page*> pages[PAGES] = {};
+	std::atomic<unsigned> size{0}; // Reserved indices, including in-flight.
+
+	MallocAllocator allocator; // Thread-safe, unlike Arena or Pool.
+
+	/*
+	 * Returns the object in `slot`, creating it first if it's still null.
+	 * When several threads race to create it, one of them wins and the
+	 * others destroy theirs and take the winner's.
+	 */
+	template <typename P, typename Create, typename Destroy>
+	static P* getOrCreate(std::atomic<P*>& slot, Create create,
+	                      Destroy destroy)
+	{
+		P* existing = slot.load(std::memory_order_acquire);
+		if (existing) return existing;
+
+		P* created = create();
+		if (slot.compare_exchange_strong(existing, created,
+		                                 std::memory_order_acq_rel,
+		                                 std::memory_order_acquire))
+			return created;
+
+		destroy(created);
+		return existing;
+	}
+
+	Page* newPage()
+	{
+		void* memory =
+		    allocator.allocate(PAGE_SIZE * sizeof(Page), alignof(Page));
+		traceAllocate<ConcurrentArray>(memory, PAGE_SIZE * sizeof(Page));
+		Page* page = static_cast<Page*>(memory);
+		for (unsigned i = 0; i < PAGE_SIZE; ++i)
+			new (page + i) Page(nullptr);
+		return page;
+	}
+
+	void deletePage(Page* page)
+	{
+		// std::atomic<T*> is trivially destructible.
+		traceDeallocate<ConcurrentArray>(page, PAGE_SIZE * sizeof(Page));
+		allocator.deallocate(page, PAGE_SIZE * sizeof(Page));
+	}
+
+	T* newChunk()
+	{
+		void* memory = allocator.allocate(CHUNK_SIZE * sizeof(T), alignof(T));
+		traceAllocate<ConcurrentArray>(memory, CHUNK_SIZE * sizeof(T));
+		return static_cast<T*>(memory);
+	}
+
+	void deleteChunk(T* chunk)
+	{
+		traceDeallocate<ConcurrentArray>(chunk, CHUNK_SIZE * sizeof(T));
+		allocator.deallocate(chunk, CHUNK_SIZE * sizeof(T));
+	}
+
+	// The raw slot for element i, allocating its chunk if needed.
+	T* slot(unsigned i)
+	{
+		Page* page = getOrCreate(
+		    pages[i >> (CHUNK_BITS + PAGE_BITS)], [&] { return newPage(); },
+		    [&](Page* p) { deletePage(p); });
+		T* chunk = getOrCreate(
+		    page[(i >> CHUNK_BITS) & (PAGE_SIZE - 1)],
+		    [&] { return newChunk(); }, [&](T* c) { deleteChunk(c); });
+		return chunk + (i & (CHUNK_SIZE - 1));
+	}
+
+	T* find(unsigned i) const
+	{
+		Page* page = pages[i >> (CHUNK_BITS + PAGE_BITS)].load(
+		    std::memory_order_acquire);
+		T* chunk = page[(i >> CHUNK_BITS) & (PAGE_SIZE - 1)].load(
+		    std::memory_order_acquire);
+		return chunk + (i & (CHUNK_SIZE - 1));
+	}
+
+public:
+	ConcurrentArray() = default;
+
+	// The elements can't be moved, and neither can the array.
+	ConcurrentArray(ConcurrentArray const&) = delete;
+	ConcurrentArray& operator=(ConcurrentArray const&) = delete;
+
+	/*
+	 * Constructs a new element at the end from `args`, and returns its index.
+	 * Safe to call from many threads at once.
+	 */
+	template <typename... Args> unsigned emplace(Args&&... args)
+	{
+		unsigned i = size.fetch_add(1, std::memory_order_relaxed);
+		new (slot(i)) T(std::forward<Args>(args)...);
+		return i;
+	}
+
+	unsigned push(T const& newElement) { return emplace(newElement); }
+
+	unsigned push(T&& newElement) { return emplace(std::move(newElement)); }
+
+	/*
+	 * The number of pushed elements - including ones still being
+	 * constructed, if other threads are pushing right now.
+	 */
+	unsigned getSize() const { return size.load(std::memory_order_acquire); }
+
+	T& operator[](unsigned i) { return *find(i); }
+	T const& operator[](unsigned i) const { return *find(i); }
+
+	~ConcurrentArray()
+	{
+		unsigned count = size.load();
+		for (unsigned i = 0; i < count; ++i)
+			find(i)->~T();
+
+		for (unsigned p = 0; p < PAGES; ++p) {
+			Page* page = pages[p].load();
+			if (!page) continue;
+
+			for (unsigned c = 0; c < PAGE_SIZE; ++c)
+				if (T* chunk = page[c].load()) deleteChunk(chunk);
+			deletePage(page);
+		}
+	}
+};
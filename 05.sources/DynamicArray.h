@@ -1,111 +1,360 @@
 #pragma once
 
-template <typename T> struct DynamicArray
+#include "AllocationTrace.h"
+#include "Allocator.h"
+#include "Elements.h"
+#include <cstring>
+#include <new>
+#include <utility>
+
+/*
+ * NOTE: The memory comes from `Allocator` - malloc() by default, or e.g. an
+ * Arena or a Pool (see Allocator.h):
+ *     Arena frame;
+ *     DynamicArray<Position, ArenaAllocator> positions{ArenaAllocator{frame}};
+ */
+template <typename T, typename Allocator = MallocAllocator> struct DynamicArray
 {
 private:
 	// Usage of T!
 	// Gets replaced with the actual type we pass. E.g. DynamicArray<Circle>
+	// NOTE: `array` points to *raw* memory. Only the slots in [0, size) hold
+	// constructed objects; the rest are bytes waiting for placement new.
 	T* array;
 	unsigned size;
 
+	// How many elements `array` has room for. Always `size <= allocated`.
+	// The slots in [size, allocated) are spare room for future push() calls.
+	unsigned allocated;
+
+	Allocator allocator;
+
+	using Ops = Elements<T>;
+
+	// Memory for `n` elements, without constructing any of them.
+	T* allocate(unsigned n)
+	{
+		if (!n) return nullptr;
+		T* p = static_cast<T*>(allocator.allocate(n * sizeof(T), alignof(T)));
+		traceAllocate<DynamicArray>(p, n * sizeof(T));
+		return p;
+	}
+
+	void deallocate(T* p, unsigned n)
+	{
+		if (!p) return;
+		traceDeallocate<DynamicArray>(p, n * sizeof(T));
+		allocator.deallocate(p, n * sizeof(T));
+	}
+
+	/*
+	 * Moves the elements into `resized` (raw memory with room for
+	 * `newCapacity` elements) and releases the old block. If moving throws,
+	 * the array is left untouched and `resized` is left to the caller.
+	 */
+	void moveInto(T* resized, unsigned newCapacity)
+	{
+		Ops::moveInto(resized, array, size);
+
+		Ops::destroy(array, array + size);
+		deallocate(array, allocated);
+		array = resized;
+		allocated = newCapacity;
+	}
+
+	// The only place where `array` gets reallocated to an exact capacity.
+	void reallocate(unsigned newCapacity)
+	{
+		if constexpr (Ops::isTrivial) {
+			// realloc() can often just extend the block in place, and copies
+			// the bytes with a single memcpy when it can't.
+			if (!newCapacity) {
+				deallocate(array, allocated);
+				array = nullptr;
+			} else {
+				AllocationStats* traced = nullptr;
+				if (array) traced = traceReallocating<DynamicArray>(array);
+				T* resized = static_cast<T*>(allocator.reallocate(
+				    array, allocated * sizeof(T), newCapacity * sizeof(T),
+				    alignof(T)));
+				if (allocated)
+					traceReallocate<DynamicArray>(traced, resized,
+					                              allocated * sizeof(T),
+					                              newCapacity * sizeof(T));
+				else
+					traceAllocate<DynamicArray>(resized,
+					                            newCapacity * sizeof(T));
+				array = resized;
+			}
+			allocated = newCapacity;
+			return;
+		}
+
+		T* resized = allocate(newCapacity);
+		try {
+			moveInto(resized, newCapacity);
+		} catch (...) {
+			deallocate(resized, newCapacity);
+			throw;
+		}
+	}
+
 public:
 	/*
 	 * Constructor - an automatically called function on object initialization.
-	 * @TODO: check what happens if you pass n = 0, i.e. what does `new T[0]`
-	 * do. Look it up on the internet and explain what you observed.
-	 *
-	 * @TODO. Proper initialization of the member fields
+	 * Creates `n` value-initialized elements (T{}). If one of them throws,
+	 * the ones already made are destroyed.
 	 */
-	DynamicArray(unsigned n) : array{new T[n]}, size{n}
+	DynamicArray(unsigned n, Allocator const& allocator = Allocator())
+	    : array{nullptr}, size{0}, allocated{0}, allocator{allocator}
 	{
-		//cout << "Dynamic array allocated #" << (count_alloc++) << endl;
+		array = allocate(n);
+		allocated = n;
+		try {
+			for (; size < n; ++size)
+				new (array + size) T();
+		} catch (...) {
+			Ops::destroy(array, array + size);
+			deallocate(array, allocated);
+			throw;
+		}
 	}
 
-	DynamicArray() : array{nullptr}, size{0} {}
+	DynamicArray() : array{nullptr}, size{0}, allocated{0}, allocator{} {}
 
-	unsigned getSize() { return this->size; }
+	explicit DynamicArray(Allocator const& allocator)
+	    : array{nullptr}, size{0}, allocated{0}, allocator{allocator}
+	{
+	}
+
+	// Copies only the constructed elements, with no spare capacity. The copy
+	// allocates from the same place as `other`.
+	DynamicArray(DynamicArray const& other)
+	    : array{nullptr}, size{0}, allocated{0}, allocator{other.allocator}
+	{
+		array = allocate(other.size);
+		allocated = other.size;
+		try {
+			Ops::copyInto(array, other.array, other.size);
+		} catch (...) {
+			deallocate(array, allocated);
+			throw;
+		}
+		size = other.size;
+	}
+
+	// Steals the memory of `other`, leaving it empty. No element is touched.
+	DynamicArray(DynamicArray&& other) noexcept
+	    : array{other.array}, size{other.size}, allocated{other.allocated},
+	      allocator{other.allocator}
+	{
+		other.array = nullptr;
+		other.size = other.allocated = 0;
+	}
+
+	// NOTE: Takes the argument by value - the copy (or move) happens on the
+	// call, and then we just swap. Works for both copy and move assignment.
+	DynamicArray& operator=(DynamicArray other) noexcept
+	{
+		std::swap(array, other.array);
+		std::swap(size, other.size);
+		std::swap(allocated, other.allocated);
+		std::swap(allocator, other.allocator);
+		return *this;
+	}
+
+	unsigned getSize() const { return this->size; }
+
+	// Number of elements the array can hold before it has to reallocate.
+	unsigned capacity() const { return allocated; }
 
 	T& operator[](unsigned i) { return array[i]; }
+	T const& operator[](unsigned i) const { return array[i]; }
 
 	/*
-	 * Pushes an element at the end of the array, or rather creates a new array
-	 * from the old with one element more at the right end.
+	 * Makes sure there is room for at least `n` elements, so that the next
+	 * (n - size) push() calls won't reallocate. Use it before bulk loads when
+	 * the final count is known. Never shrinks.
 	 */
-	void push(const T& newElement)
+	void reserve(unsigned n)
 	{
-		// 1. Allocate memory for the updated array of size one more than
-		// this->array.
-		// @TODO think: how to optimize memory allocations when push() is called
-		// multiple times on the same instance.
-		T* extended = new T[size + 1];
+		if (n > allocated) reallocate(n);
+	}
 
-		// 2. Move everything from this->array to `extended`.
-		// Elements range from the 0th to (size - 1)th index.
-		for (int i = 0; i < size; ++i)
-			extended[i] = array[i];
+	/*
+	 * Appends `n` elements which `construct(raw)` constructs in place, in the
+	 * raw memory at `raw` - e.g. from many threads at once, or for a T with
+	 * no default constructor to assign over.
+	 * NOTE: `construct` must construct all `n` elements, or destroy the ones
+	 * it made and throw.
+	 */
+	template <typename Construct>
+	void appendInPlace(unsigned n, Construct construct)
+	{
+		reserve(size + n);
+		construct(array + size);
+		size += n;
+	}
 
-		// 3. Note that we didn't put anything in the last position of
-		// `extended` - `extended[size]` (remember, it's size is (size + 1)).
-		// We copy the element passed as an argument into the new array.
-		extended[size] = newElement;
+	/*
+	 * Releases the spare capacity, e.g. after the array is fully built.
+	 */
+	void shrink_to_fit()
+	{
+		if (allocated > size) reallocate(size);
+	}
 
-		// 4. NOTE: The old memory is currently referenced by the current value
-		// of this->array. We free the memory for the old array as it's not
-		// needed anymore.
-		delete[] array;
+	/*
+	 * Constructs a new element at the end of the array directly from the
+	 * constructor arguments `args` - no temporary T, no copy.
+	 * E.g. `people.emplace(city, loc, health)`.
+	 * When the spare room runs out, the capacity is doubled (geometric
+	 * growth), so n calls cause only O(log n) reallocations and O(n) element
+	 * moves in total - amortized O(1) per call.
+	 */
+	template <typename... Args> T& emplace(Args&&... args)
+	{
+		if (size < allocated) {
+			new (array + size) T(std::forward<Args>(args)...);
+		} else if constexpr (Ops::isTrivial) {
+			// NOTE: `args` may refer to an element of this very array, which
+			// realloc() may move. Build the new value on the side first.
+			T newElement(std::forward<Args>(args)...);
+			reallocate(allocated ? allocated * 2 : 4);
+			std::memcpy(static_cast<void*>(array + size), &newElement,
+			            sizeof(T));
+		} else {
+			// NOTE: `args` may refer to an element of this very array, so we
+			// construct the new element before the old memory is released.
+			unsigned newCapacity = allocated ? allocated * 2 : 4;
+			T* resized = allocate(newCapacity);
+			try {
+				new (resized + size) T(std::forward<Args>(args)...);
+			} catch (...) {
+				deallocate(resized, newCapacity);
+				throw;
+			}
 
-		size++;
+			try {
+				moveInto(resized, newCapacity);
+			} catch (...) {
+				resized[size].~T();
+				deallocate(resized, newCapacity);
+				throw;
+			}
+		}
 
-		// 5. Unless we execute the following line, this->array will point to
-		// the old memory block which we just released back to the operating
-		// system. We finish by reassigning `this->array` to point to the newly
-		// allocated `extended`.
-		array = extended;
+		return array[size++];
+	}
 
-		// @TODO think: what would happen if we swap the last two actions?
+	/*
+	 * Pushes an element at the end of the array.
+	 * NOTE: Unlike the first versions of push(), we don't allocate a new array
+	 * on every call - see emplace().
+	 */
+	void push(const T& newElement) { emplace(newElement); }
+
+	void push(T&& newElement) { emplace(std::move(newElement)); }
+
+	/*
+	 * Appends copies of all elements of `other` at the end of this array.
+	 * Reallocates at most once.
+	 */
+	void extendWith(DynamicArray const& other)
+	{
+		unsigned count = other.size;
+		if (size + count > allocated) {
+			unsigned newCapacity = allocated * 2;
+			if (newCapacity < size + count) newCapacity = size + count;
+
+			// NOTE: `other` may be this very array, so we copy from a copy
+			// when the reallocation would pull the memory from under us.
+			if (&other == this) {
+				DynamicArray copy{other};
+				reserve(newCapacity);
+				extendWith(copy);
+				return;
+			}
+			reserve(newCapacity);
+		}
+
+		Ops::copyInto(array + size, other.array, count);
+		size += count;
 	}
 
 	/*
-	 * Removes the n'th element, or rather creates a new array from the old with
-	 * its n'th element removed.
+	 * Removes the n'th element, keeping the order of the rest.
+	 * NOTE: No reallocation - the elements after n are shifted one position to
+	 * the left and the last slot becomes spare capacity. O(size - n).
 	 */
 	void deleteAt(unsigned n)
 	{
-		// Allocate memory for the shrunken array
-		T* shrunken = new T[size - 1];
+		Ops::shiftLeft(array + n, array + n + 1, size - n - 1);
 
-		// Copy everything from `array` into `shrunken`, except for the array[n]
-		// NOTE: Can be done with 2 `for` loops without conditional blocks.
-		for (unsigned i = 0; i < size; ++i) {
-			if (i < n) shrunken[i] = array[i];
+		size--;
+		array[size].~T();
+	}
 
-			if (i > n) shrunken[i - 1] = array[i];
-		}
+	/*
+	 * Removes the elements with indices [start, start + length), keeping the
+	 * order of the rest. Shifts the tail only once, regardless of `length`.
+	 */
+	void deleteRange(unsigned start, unsigned length)
+	{
+		if (start >= size) return;
+		if (length > size - start) length = size - start;
+
+		unsigned tail = start + length;
+		Ops::shiftLeft(array + start, array + tail, size - tail);
 
-		// NOTE: The old memory is currently referenced by the current value of
-		// this->array. We free the memory for the old array as it's not needed
-		// anymore.
-		delete[] array;
+		Ops::destroy(array + size - length, array + size);
+		size -= length;
+	}
+
+	/*
+	 * Removes the n'th element in O(1) by moving the last element in its
+	 * place. Use it when the order of the elements doesn't matter.
+	 */
+	void deleteAtUnordered(unsigned n)
+	{
+		if (n != size - 1) Ops::relocate(array + n, array + size - 1);
 
 		size--;
+		array[size].~T();
+	}
+
+	/*
+	 * Removes every element for which `pred(element)` is true, keeping the
+	 * order of the rest. A single pass: each kept element is moved at most
+	 * once, so removing k of n elements is O(n), not O(k * n).
+	 * Returns the number of removed elements.
+	 */
+	template <typename Predicate> unsigned eraseIf(Predicate pred)
+	{
+		unsigned kept = 0;
+		for (unsigned i = 0; i < size; ++i) {
+			if (pred(array[i])) continue;
+
+			if (kept != i) Ops::relocate(array + kept, array + i);
+			kept++;
+		}
 
-		// Unless we execute the following line, this->array will point to the
-		// old memory block which we just released back to the operating system.
-		// We finish by reassigning `this->array` to point to the newly
-		// allocated `extended`.
-		array = shrunken;
+		unsigned removed = size - kept;
+		Ops::destroy(array + kept, array + size);
+		size = kept;
+		return removed;
 	}
 
 	/*
 	 * Destructor - a special function, automatically called when the object
 	 * leaves scope (the set of curly braces it was defiend within).
 	 *
-	 * An easy way not to forget to free whatever you allocated!
+	 * NOTE: With raw memory we have to do by hand what `delete[]` did for us:
+	 * first destroy the constructed elements, then release the memory.
 	 */
 	~DynamicArray()
 	{
-		//cout << "Before delete" << endl;
-		delete[] array;
-		//cout << "After delete" << endl;
+		Ops::destroy(array, array + size);
+		deallocate(array, allocated);
 	}
 };
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/*
+ * The element-level building blocks shared by DynamicArray and
+ * SmallDynamicArray: they all work on raw memory where only some of the slots
+ * hold constructed objects.
+ */
+template <typename T> struct Elements
+{
+	// Types like int, Position or Point whose objects are just bytes. We move
+	// them around in bulk with memcpy/memmove/realloc instead of element by
+	// element.
+	static constexpr bool isTrivial = std::is_trivially_copyable<T>::value;
+
+	// Calls the destructors of [from, to), leaving the memory in place.
+	static void destroy(T* from, T* to)
+	{
+		if constexpr (isTrivial) return;
+
+		for (; from != to; ++from)
+			from->~T();
+	}
+
+	/*
+	 * Puts the value of `*src` into the already constructed `*dst`.
+	 * NOTE: Types like Person (which holds a `City&`) can't be assigned, so
+	 * for them we destroy `*dst` and move-construct a new object in its place.
+	 */
+	static void relocate(T* dst, T* src)
+	{
+		if constexpr (std::is_move_assignable<T>::value) {
+			*dst = std::move(*src);
+		} else {
+			dst->~T();
+			new (dst) T(std::move(*src));
+		}
+	}
+
+	/*
+	 * Moves the `count` elements starting at `src` to `dst` (towards the
+	 * front, `dst < src`), e.g. to close the gap after an erase.
+	 */
+	static void shiftLeft(T* dst, T* src, unsigned count)
+	{
+		if constexpr (isTrivial) {
+			if (count)
+				std::memmove(static_cast<void*>(dst), src, count * sizeof(T));
+		} else {
+			for (unsigned i = 0; i < count; ++i)
+				relocate(dst + i, src + i);
+		}
+	}
+
+	/*
+	 * Copy-constructs [src, src + count) into the raw memory at `dst`.
+	 * If a copy throws, the already made copies are destroyed.
+	 */
+	static void copyInto(T* dst, T const* src, unsigned count)
+	{
+		if constexpr (isTrivial) {
+			if (count)
+				std::memcpy(static_cast<void*>(dst), src, count * sizeof(T));
+		} else {
+			unsigned i = 0;
+			try {
+				for (; i < count; ++i)
+					new (dst + i) T(src[i]);
+			} catch (...) {
+				destroy(dst, dst + i);
+				throw;
+			}
+		}
+	}
+
+	/*
+	 * Move-constructs [src, src + count) into the raw memory at `dst`.
+	 * NOTE: std::move_if_noexcept moves the elements unless their move
+	 * constructor may throw - then it copies, so that a failure half-way
+	 * leaves the source untouched. The source objects are *not* destroyed.
+	 */
+	static void moveInto(T* dst, T* src, unsigned count)
+	{
+		if constexpr (isTrivial) {
+			if (count)
+				std::memcpy(static_cast<void*>(dst), src, count * sizeof(T));
+		} else {
+			unsigned i = 0;
+			try {
+				for (; i < count; ++i)
+					new (dst + i) T(std::move_if_noexcept(src[i]));
+			} catch (...) {
+				destroy(dst, dst + i);
+				throw;
+			}
+		}
+	}
+};
@@ -0,0 +1,407 @@
+#pragma once
+
+#include "MatrixExpression.h"
+#include <initializer_list>
+#include <stdexcept>
+
+/*
+ * A matrix whose size is part of its type: FixedMatrix<float, 3, 3>.
+ *
+ * For the small transforms of the simulation (2x2, 3x3, 4x4) Matrix<T> is
+ * heavy: a heap allocation per matrix and sizes known only at run time.
+ * Here the elements are a plain array inside the object - on the stack, no
+ * allocation - and every loop has a constant trip count, so the compiler
+ * unrolls it and keeps the elements in registers. Everything is constexpr:
+ *
+ *     constexpr FixedMatrix<float, 2, 2> rotate90{0, -1,
+ *                                                 1, 0};
+ *     static_assert(rotate90 * rotate90 * rotate90 * rotate90 ==
+ *                   FixedMatrix<float, 2, 2>::identity());
+ *
+ * NOTE: It is a separate class rather than a Matrix<T, R, C> specialization:
+ * the second parameter of Matrix is its allocator.
+ * NOTE: It is a MatrixExpression too, so it converts to a Matrix:
+ *     Matrix<float> dynamic{fixed};
+ * and back with FixedMatrix<float, 3, 3>::from(dynamic).
+ */
+template <typename T, unsigned R, unsigned C>
+class FixedMatrix : public MatrixExpression<FixedMatrix<T, R, C>>
+{
+	static_assert(R > 0 && C > 0, "A matrix has at least one element");
+
+	T cells[R * C]; // Row after row.
+
+public:
+	using Value = T;
+	static constexpr bool isMatrix = true;
+
+	// All zeros (T{}).
+	constexpr FixedMatrix() : cells{} {}
+
+	// The elements row after row: FixedMatrix<int, 2, 2>{1, 2, 3, 4}.
+	constexpr FixedMatrix(std::initializer_list<T> values) : cells{}
+	{
+		if (values.size() != R * C)
+			throw std::runtime_error("Wrong number of matrix elements");
+
+		unsigned i = 0;
+		for (T const& value : values)
+			cells[i++] = value;
+	}
+
+	static constexpr FixedMatrix identity()
+	{
+		static_assert(R == C, "Only square matrices have an identity");
+
+		FixedMatrix result;
+		for (unsigned i = 0; i < R; ++i)
+			result.cells[i * C + i] = T(1);
+		return result;
+	}
+
+	// A copy of any matrix expression of the same size, e.g. a Matrix.
+	template <typename E>
+	static FixedMatrix from(MatrixExpression<E> const& expression)
+	{
+		E const& e = expression.self();
+		if (e.getRows() != R || e.getCols() != C)
+			throw std::runtime_error("The matrices must be of the same size");
+
+		FixedMatrix result;
+		for (unsigned i = 0; i < R; ++i)
+			for (unsigned j = 0; j < C; ++j)
+				result.cells[i * C + j] = e.at(i, j);
+		return result;
+	}
+
+	static constexpr unsigned getRows() { return R; }
+	static constexpr unsigned getCols() { return C; }
+	static constexpr unsigned getStride() { return C; }
+
+	constexpr T* getData() { return cells; }
+	constexpr T const* getData() const { return cells; }
+
+	constexpr T* row(unsigned i) { return cells + i * C; }
+	constexpr T const* row(unsigned i) const { return cells + i * C; }
+
+	constexpr T& get(unsigned row, unsigned col)
+	{
+		return cells[row * C + col];
+	}
+
+	constexpr T const& get(unsigned row, unsigned col) const
+	{
+		return cells[row * C + col];
+	}
+
+	constexpr T const& at(unsigned i, unsigned j) const { return get(i, j); }
+
+	bool aliases(EvaluationTarget const& target) const
+	{
+		return storageAliases(target, cells, R, C, C, 1);
+	}
+
+	constexpr void set(unsigned row, unsigned col, T const& newValue)
+	{
+		cells[row * C + col] = newValue;
+	}
+
+	// ---- Element-wise arithmetic ------------------------------------------
+
+	constexpr FixedMatrix& operator+=(FixedMatrix const& other)
+	{
+		for (unsigned i = 0; i < R * C; ++i)
+			cells[i] += other.cells[i];
+		return *this;
+	}
+
+	constexpr FixedMatrix& operator-=(FixedMatrix const& other)
+	{
+		for (unsigned i = 0; i < R * C; ++i)
+			cells[i] -= other.cells[i];
+		return *this;
+	}
+
+	constexpr FixedMatrix& operator*=(T const& scalar)
+	{
+		for (unsigned i = 0; i < R * C; ++i)
+			cells[i] *= scalar;
+		return *this;
+	}
+
+	constexpr FixedMatrix& operator/=(T const& scalar)
+	{
+		for (unsigned i = 0; i < R * C; ++i)
+			cells[i] /= scalar;
+		return *this;
+	}
+
+	constexpr bool operator==(FixedMatrix const& other) const
+	{
+		for (unsigned i = 0; i < R * C; ++i)
+			if (!(cells[i] == other.cells[i])) return false;
+		return true;
+	}
+
+	constexpr bool operator!=(FixedMatrix const& other) const
+	{
+		return !(*this == other);
+	}
+};
+
+/*
+ * NOTE: These overloads take FixedMatrix exactly, so they win over the lazy
+ * operators of MatrixExpression.h: small matrices are computed right away,
+ * which is cheaper than building an expression.
+ * The scalar is `typename FixedMatrix<...>::Value` to keep it out of the
+ * deduction, like in MatrixExpression.h - `m * 2` works for floats.
+ */
+
+template <typename T, unsigned R, unsigned C>
+constexpr FixedMatrix<T, R, C> operator+(FixedMatrix<T, R, C> a,
+                                         FixedMatrix<T, R, C> const& b)
+{
+	return a += b;
+}
+
+template <typename T, unsigned R, unsigned C>
+constexpr FixedMatrix<T, R, C> operator-(FixedMatrix<T, R, C> a,
+                                         FixedMatrix<T, R, C> const& b)
+{
+	return a -= b;
+}
+
+template <typename T, unsigned R, unsigned C>
+constexpr FixedMatrix<T, R, C> operator-(FixedMatrix<T, R, C> const& m)
+{
+	return m * T(-1);
+}
+
+template <typename T, unsigned R, unsigned C>
+constexpr FixedMatrix<T, R, C>
+operator*(FixedMatrix<T, R, C> m,
+          typename FixedMatrix<T, R, C>::Value const& scalar)
+{
+	return m *= scalar;
+}
+
+template <typename T, unsigned R, unsigned C>
+constexpr FixedMatrix<T, R, C>
+operator*(typename FixedMatrix<T, R, C>::Value const& scalar,
+          FixedMatrix<T, R, C> m)
+{
+	return m *= scalar;
+}
+
+template <typename T, unsigned R, unsigned C>
+constexpr FixedMatrix<T, R, C>
+operator/(FixedMatrix<T, R, C> m,
+          typename FixedMatrix<T, R, C>::Value const& scalar)
+{
+	return m /= scalar;
+}
+
+// ---- Matrix product -------------------------------------------------------
+
+// (R x K) * (K x C). All three loops have constant bounds and get unrolled.
+template <typename T, unsigned R, unsigned K, unsigned C>
+constexpr FixedMatrix<T, R, C> operator*(FixedMatrix<T, R, K> const& a,
+                                         FixedMatrix<T, K, C> const& b)
+{
+	FixedMatrix<T, R, C> result;
+	for (unsigned i = 0; i < R; ++i)
+		for (unsigned k = 0; k < K; ++k)
+			for (unsigned j = 0; j < C; ++j)
+				result.get(i, j) += a.get(i, k) * b.get(k, j);
+	return result;
+}
+
+template <typename T, unsigned R, unsigned C>
+constexpr FixedMatrix<T, C, R> transpose(FixedMatrix<T, R, C> const& m)
+{
+	FixedMatrix<T, C, R> result;
+	for (unsigned i = 0; i < R; ++i)
+		for (unsigned j = 0; j < C; ++j)
+			result.get(j, i) = m.get(i, j);
+	return result;
+}
+
+// ---- Determinant and inverse ----------------------------------------------
+
+/*
+ * 1x1 to 4x4 use closed formulas (no branches, no pivoting); bigger
+ * matrices use Gaussian elimination.
+ */
+template <typename T, unsigned N>
+constexpr T determinant(FixedMatrix<T, N, N> const& m)
+{
+	auto a = [&](unsigned i, unsigned j) { return m.get(i, j); };
+
+	if constexpr (N == 1) {
+		return a(0, 0);
+	} else if constexpr (N == 2) {
+		return a(0, 0) * a(1, 1) - a(0, 1) * a(1, 0);
+	} else if constexpr (N == 3) {
+		return a(0, 0) * (a(1, 1) * a(2, 2) - a(1, 2) * a(2, 1)) -
+		       a(0, 1) * (a(1, 0) * a(2, 2) - a(1, 2) * a(2, 0)) +
+		       a(0, 2) * (a(1, 0) * a(2, 1) - a(1, 1) * a(2, 0));
+	} else if constexpr (N == 4) {
+		// The 2x2 minors of the top two rows (s) and the bottom two (c).
+		T s0 = a(0, 0) * a(1, 1) - a(1, 0) * a(0, 1);
+		T s1 = a(0, 0) * a(1, 2) - a(1, 0) * a(0, 2);
+		T s2 = a(0, 0) * a(1, 3) - a(1, 0) * a(0, 3);
+		T s3 = a(0, 1) * a(1, 2) - a(1, 1) * a(0, 2);
+		T s4 = a(0, 1) * a(1, 3) - a(1, 1) * a(0, 3);
+		T s5 = a(0, 2) * a(1, 3) - a(1, 2) * a(0, 3);
+		T c0 = a(2, 0) * a(3, 1) - a(3, 0) * a(2, 1);
+		T c1 = a(2, 0) * a(3, 2) - a(3, 0) * a(2, 2);
+		T c2 = a(2, 0) * a(3, 3) - a(3, 0) * a(2, 3);
+		T c3 = a(2, 1) * a(3, 2) - a(3, 1) * a(2, 2);
+		T c4 = a(2, 1) * a(3, 3) - a(3, 1) * a(2, 3);
+		T c5 = a(2, 2) * a(3, 3) - a(3, 2) * a(2, 3);
+		return s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+	} else {
+		FixedMatrix<T, N, N> u = m;
+		T result = T(1);
+		for (unsigned col = 0; col < N; ++col) {
+			unsigned pivot = col;
+			for (unsigned i = col + 1; i < N; ++i) {
+				T x = u.get(i, col), p = u.get(pivot, col);
+				if ((x < T{} ? -x : x) > (p < T{} ? -p : p)) pivot = i;
+			}
+			if (u.get(pivot, col) == T{}) return T{};
+
+			if (pivot != col) {
+				result = -result;
+				for (unsigned j = 0; j < N; ++j) {
+					T t = u.get(col, j);
+					u.get(col, j) = u.get(pivot, j);
+					u.get(pivot, j) = t;
+				}
+			}
+
+			result *= u.get(col, col);
+			for (unsigned i = col + 1; i < N; ++i) {
+				T factor = u.get(i, col) / u.get(col, col);
+				for (unsigned j = col; j < N; ++j)
+					u.get(i, j) -= factor * u.get(col, j);
+			}
+		}
+		return result;
+	}
+}
+
+// Throws std::runtime_error if `m` is singular (its determinant is 0).
+template <typename T, unsigned N>
+constexpr FixedMatrix<T, N, N> inverse(FixedMatrix<T, N, N> const& m)
+{
+	auto a = [&](unsigned i, unsigned j) { return m.get(i, j); };
+	auto singular = [] {
+		throw std::runtime_error("The matrix is singular");
+	};
+
+	if constexpr (N == 1) {
+		if (a(0, 0) == T{}) singular();
+		return {T(1) / a(0, 0)};
+	} else if constexpr (N == 2) {
+		T det = determinant(m);
+		if (det == T{}) singular();
+		return {a(1, 1) / det, -a(0, 1) / det,
+		        -a(1, 0) / det, a(0, 0) / det};
+	} else if constexpr (N == 3) {
+		// The transposed matrix of cofactors, divided by the determinant.
+		T c00 = a(1, 1) * a(2, 2) - a(1, 2) * a(2, 1);
+		T c01 = a(1, 2) * a(2, 0) - a(1, 0) * a(2, 2);
+		T c02 = a(1, 0) * a(2, 1) - a(1, 1) * a(2, 0);
+		T det = a(0, 0) * c00 + a(0, 1) * c01 + a(0, 2) * c02;
+		if (det == T{}) singular();
+
+		FixedMatrix<T, 3, 3> result{
+		    c00,
+		    a(0, 2) * a(2, 1) - a(0, 1) * a(2, 2),
+		    a(0, 1) * a(1, 2) - a(0, 2) * a(1, 1),
+		    c01,
+		    a(0, 0) * a(2, 2) - a(0, 2) * a(2, 0),
+		    a(0, 2) * a(1, 0) - a(0, 0) * a(1, 2),
+		    c02,
+		    a(0, 1) * a(2, 0) - a(0, 0) * a(2, 1),
+		    a(0, 0) * a(1, 1) - a(0, 1) * a(1, 0)};
+		return result / det;
+	} else if constexpr (N == 4) {
+		// Laplace expansion by the 2x2 minors of the top and bottom rows.
+		T s0 = a(0, 0) * a(1, 1) - a(1, 0) * a(0, 1);
+		T s1 = a(0, 0) * a(1, 2) - a(1, 0) * a(0, 2);
+		T s2 = a(0, 0) * a(1, 3) - a(1, 0) * a(0, 3);
+		T s3 = a(0, 1) * a(1, 2) - a(1, 1) * a(0, 2);
+		T s4 = a(0, 1) * a(1, 3) - a(1, 1) * a(0, 3);
+		T s5 = a(0, 2) * a(1, 3) - a(1, 2) * a(0, 3);
+		T c0 = a(2, 0) * a(3, 1) - a(3, 0) * a(2, 1);
+		T c1 = a(2, 0) * a(3, 2) - a(3, 0) * a(2, 2);
+		T c2 = a(2, 0) * a(3, 3) - a(3, 0) * a(2, 3);
+		T c3 = a(2, 1) * a(3, 2) - a(3, 1) * a(2, 2);
+		T c4 = a(2, 1) * a(3, 3) - a(3, 1) * a(2, 3);
+		T c5 = a(2, 2) * a(3, 3) - a(3, 2) * a(2, 3);
+
+		T det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+		if (det == T{}) singular();
+
+		FixedMatrix<T, 4, 4> result{
+		    a(1, 1) * c5 - a(1, 2) * c4 + a(1, 3) * c3,
+		    -a(0, 1) * c5 + a(0, 2) * c4 - a(0, 3) * c3,
+		    a(3, 1) * s5 - a(3, 2) * s4 + a(3, 3) * s3,
+		    -a(2, 1) * s5 + a(2, 2) * s4 - a(2, 3) * s3,
+
+		    -a(1, 0) * c5 + a(1, 2) * c2 - a(1, 3) * c1,
+		    a(0, 0) * c5 - a(0, 2) * c2 + a(0, 3) * c1,
+		    -a(3, 0) * s5 + a(3, 2) * s2 - a(3, 3) * s1,
+		    a(2, 0) * s5 - a(2, 2) * s2 + a(2, 3) * s1,
+
+		    a(1, 0) * c4 - a(1, 1) * c2 + a(1, 3) * c0,
+		    -a(0, 0) * c4 + a(0, 1) * c2 - a(0, 3) * c0,
+		    a(3, 0) * s4 - a(3, 1) * s2 + a(3, 3) * s0,
+		    -a(2, 0) * s4 + a(2, 1) * s2 - a(2, 3) * s0,
+
+		    -a(1, 0) * c3 + a(1, 1) * c1 - a(1, 2) * c0,
+		    a(0, 0) * c3 - a(0, 1) * c1 + a(0, 2) * c0,
+		    -a(3, 0) * s3 + a(3, 1) * s1 - a(3, 2) * s0,
+		    a(2, 0) * s3 - a(2, 1) * s1 + a(2, 2) * s0};
+		return result / det;
+	} else {
+		// Gauss-Jordan: reduce [m | I] to [I | m^-1].
+		FixedMatrix<T, N, N> u = m;
+		FixedMatrix<T, N, N> result = FixedMatrix<T, N, N>::identity();
+		for (unsigned col = 0; col < N; ++col) {
+			unsigned pivot = col;
+			for (unsigned i = col + 1; i < N; ++i) {
+				T x = u.get(i, col), p = u.get(pivot, col);
+				if ((x < T{} ? -x : x) > (p < T{} ? -p : p)) pivot = i;
+			}
+			if (u.get(pivot, col) == T{}) singular();
+
+			for (unsigned j = 0; j < N; ++j) {
+				T t = u.get(col, j);
+				u.get(col, j) = u.get(pivot, j);
+				u.get(pivot, j) = t;
+				t = result.get(col, j);
+				result.get(col, j) = result.get(pivot, j);
+				result.get(pivot, j) = t;
+			}
+
+			T scale = u.get(col, col);
+			for (unsigned j = 0; j < N; ++j) {
+				u.get(col, j) /= scale;
+				result.get(col, j) /= scale;
+			}
+
+			for (unsigned i = 0; i < N; ++i) {
+				if (i == col) continue;
+				T factor = u.get(i, col);
+				for (unsigned j = 0; j < N; ++j) {
+					u.get(i, j) -= factor * u.get(col, j);
+					result.get(i, j) -= factor * result.get(col, j);
+				}
+			}
+		}
+		return result;
+	}
+}
@@ -0,0 +1,296 @@
+#pragma once
+
+#include "DynamicArray.h"
+#include "Matrix.h"
+#include "MatrixExpression.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ * A binary file format for arrays and matrices of trivially copyable
+ * elements, and read-only views which map such a file into memory.
+ *
+ *     saveBinary(positions, "positions.bin");
+ *     ...
+ *     MappedArray<Position> loaded{"positions.bin"};
+ *     loaded[42].x;
+ *
+ * Opening a file reads nothing: the elements are the bytes of the file,
+ * which the OS loads page by page on first access. So a multi-gigabyte
+ * dataset is usable in milliseconds, and several processes mapping the same
+ * file share the same pages in the page cache.
+ *
+ * File layout (native byte order - the files are not portable between
+ * machines with different endianness):
+ *
+ *     FileHeader       64 bytes
+ *     elements         rows x cols, row after row, no spare columns
+ *
+ * NOTE: POSIX only (open/mmap).
+ */
+
+struct FileHeader
+{
+	static constexpr char MAGIC[8] = {'D', 'Y', 'N', 'A', 'B', 'I', 'N', '\0'};
+	static constexpr uint32_t VERSION = 1;
+
+	// What kind of numbers the elements are, to catch reading a file of
+	// floats as ints. OTHER for everything else (e.g. structs).
+	enum Kind : uint32_t { OTHER, SIGNED, UNSIGNED, FLOATING };
+
+	char magic[8];
+	uint32_t version;
+	uint32_t kind;
+	uint64_t elementSize;
+	uint64_t rows; // 1 for a DynamicArray.
+	uint64_t cols;
+	char reserved[24]; // Zero. Room for future versions.
+
+	template <typename T> static uint32_t kindOf()
+	{
+		if (std::is_floating_point<T>::value) return FLOATING;
+		if (std::is_integral<T>::value)
+			return std::is_signed<T>::value ? SIGNED : UNSIGNED;
+		return OTHER;
+	}
+
+	template <typename T> static FileHeader of(uint64_t rows, uint64_t cols)
+	{
+		FileHeader header{};
+		std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+		header.version = VERSION;
+		header.kind = kindOf<T>();
+		header.elementSize = sizeof(T);
+		header.rows = rows;
+		header.cols = cols;
+		return header;
+	}
+};
+
+static_assert(sizeof(FileHeader) == 64, "The header is part of the format");
+
+// ---- Writing --------------------------------------------------------------
+
+/*
+ * Writes `rows` rows of `cols` elements, the first one at `data` and each
+ * next one `stride` elements further.
+ */
+template <typename T>
+void writeBinary(const char* path, T const* data, unsigned rows, unsigned cols,
+                 unsigned stride)
+{
+	static_assert(std::is_trivially_copyable<T>::value,
+	              "Only trivially copyable elements can be saved as bytes");
+	static_assert(alignof(T) <= sizeof(FileHeader),
+	              "The elements start right after the header");
+
+	std::FILE* file = std::fopen(path, "wb");
+	if (!file) throw std::runtime_error(std::string("Can't create ") + path);
+
+	FileHeader header = FileHeader::of<T>(rows, cols);
+	bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1;
+	for (unsigned i = 0; ok && i < rows && cols; ++i)
+		ok = std::fwrite(data + size_t(i) * stride, sizeof(T), cols, file) ==
+		     cols;
+
+	if (std::fclose(file) != 0 || !ok)
+		throw std::runtime_error(std::string("Can't write ") + path);
+}
+
+template <typename T, typename A>
+void saveBinary(DynamicArray<T, A> const& array, const char* path)
+{
+	unsigned size = array.getSize();
+	writeBinary(path, size ? &array[0] : nullptr, 1, size, size);
+}
+
+template <typename T, typename A>
+void saveBinary(Matrix<T, A> const& matrix, const char* path)
+{
+	writeBinary(path, matrix.getData(), matrix.getRows(), matrix.getCols(),
+	            matrix.getStride());
+}
+
+// ---- Mapping --------------------------------------------------------------
+
+/*
+ * A whole file mapped read-only into memory. Unmapped in the destructor.
+ */
+class MappedFile
+{
+	void* address = nullptr;
+	size_t length = 0;
+
+public:
+	explicit MappedFile(const char* path)
+	{
+		int fd = ::open(path, O_RDONLY);
+		if (fd < 0) throw std::runtime_error(std::string("Can't open ") + path);
+
+		struct stat info;
+		if (::fstat(fd, &info) != 0) {
+			::close(fd);
+			throw std::runtime_error(std::string("Can't stat ") + path);
+		}
+		length = info.st_size;
+
+		// NOTE: mmap() of 0 bytes fails; such a file is rejected later anyway.
+		if (length) {
+			address = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+			if (address == MAP_FAILED) address = nullptr;
+		}
+		::close(fd); // The mapping keeps the file open.
+
+		if (length && !address)
+			throw std::runtime_error(std::string("Can't map ") + path);
+	}
+
+	MappedFile(MappedFile const&) = delete;
+	MappedFile& operator=(MappedFile const&) = delete;
+
+	MappedFile(MappedFile&& other) noexcept
+	    : address{other.address}, length{other.length}
+	{
+		other.address = nullptr;
+		other.length = 0;
+	}
+
+	MappedFile& operator=(MappedFile&& other) noexcept
+	{
+		std::swap(address, other.address);
+		std::swap(length, other.length);
+		return *this;
+	}
+
+	char const* getData() const { return static_cast<char const*>(address); }
+	size_t getLength() const { return length; }
+
+	~MappedFile()
+	{
+		if (address) ::munmap(address, length);
+	}
+};
+
+/*
+ * Checks that `file` holds elements of type T and returns its header.
+ */
+template <typename T>
+FileHeader const& checkHeader(MappedFile const& file, const char* path)
+{
+	static_assert(std::is_trivially_copyable<T>::value,
+	              "Only trivially copyable elements can be mapped");
+
+	auto fail = [&](const char* why) {
+		throw std::runtime_error(std::string(path) + ": " + why);
+	};
+
+	if (file.getLength() < sizeof(FileHeader)) fail("not a binary file");
+
+	// mmap() returns page-aligned memory, so the header is aligned too.
+	auto const& header = *reinterpret_cast<FileHeader const*>(file.getData());
+	if (std::memcmp(header.magic, FileHeader::MAGIC, sizeof(header.magic)))
+		fail("not a binary file");
+	if (header.version != FileHeader::VERSION) fail("unsupported version");
+	if (header.elementSize != sizeof(T) ||
+	    header.kind != FileHeader::kindOf<T>())
+		fail("wrong element type");
+	if (header.rows > ~0u || header.cols > ~0u) fail("too many elements");
+
+	// NOTE: Divides first - rows * cols * sizeof(T) can overflow, and then a
+	// short file would pass.
+	uint64_t bytes = file.getLength() - sizeof(FileHeader);
+	if (header.rows != 0 && header.cols > bytes / sizeof(T) / header.rows)
+		fail("wrong file size");
+	if (bytes != header.rows * header.cols * sizeof(T))
+		fail("wrong file size");
+
+	return header;
+}
+
+/*
+ * A read-only DynamicArray backed by a file written by saveBinary().
+ */
+template <typename T> class MappedArray
+{
+	MappedFile file;
+	T const* array;
+	unsigned size;
+
+public:
+	explicit MappedArray(const char* path) : file{path}
+	{
+		FileHeader const& header = checkHeader<T>(file, path);
+		if (header.rows != 1)
+			throw std::runtime_error(std::string(path) + ": not an array");
+
+		array = reinterpret_cast<T const*>(file.getData() + sizeof(header));
+		size = header.cols;
+	}
+
+	unsigned getSize() const { return size; }
+
+	T const& operator[](unsigned index) const { return array[index]; }
+
+	// An ordinary, modifiable copy.
+	DynamicArray<T> toDynamicArray() const
+	{
+		DynamicArray<T> copy;
+		copy.reserve(size);
+		for (unsigned i = 0; i < size; ++i)
+			copy.push(array[i]);
+		return copy;
+	}
+};
+
+/*
+ * A read-only Matrix backed by a file written by saveBinary().
+ *
+ * NOTE: It is a MatrixExpression too, so it mixes with matrices:
+ *     Matrix<float> sum = mapped + changes;
+ *     Matrix<float> copy{mapped};
+ */
+template <typename T>
+class MappedMatrix : public MatrixExpression<MappedMatrix<T>>
+{
+	MappedFile file;
+	T const* data;
+	unsigned rows, cols;
+
+public:
+	using Value = T;
+	static constexpr bool isMatrix = true; // Kept by reference in expressions.
+
+	explicit MappedMatrix(const char* path) : file{path}
+	{
+		FileHeader const& header = checkHeader<T>(file, path);
+
+		data = reinterpret_cast<T const*>(file.getData() + sizeof(header));
+		rows = header.rows;
+		cols = header.cols;
+	}
+
+	unsigned getRows() const { return rows; }
+	unsigned getCols() const { return cols; }
+
+	// The rows are stored without spare columns.
+	unsigned getStride() const { return cols; }
+	T const* getData() const { return data; }
+	T const* row(unsigned i) const { return data + size_t(i) * cols; }
+
+	T const& get(int row, int col) const { return this->row(row)[col]; }
+	T const& at(unsigned i, unsigned j) const { return row(i)[j]; }
+
+	bool aliases(EvaluationTarget const& target) const
+	{
+		return storageAliases(target, data, rows, cols, cols, 1);
+	}
+};
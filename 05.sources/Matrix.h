@@ -0,0 +1,350 @@
+#pragma once
+
+#include "AllocationTrace.h"
+#include "Allocator.h"
+#include "Elements.h"
+#include "MatrixExpression.h"
+#include "MatrixView.h"
+#include <new>
+#include <utility>
+
+/*
+ * A rows x cols matrix stored in a single contiguous block, row after row
+ * ("row-major"). Element (row, col) lives at data[row * stride + col].
+ *
+ * NOTE: `stride` (the distance between two rows) can be bigger than `cols` -
+ * the extra columns are spare room for addColumn(), just like DynamicArray
+ * keeps spare room for push(). Likewise there is spare room for addRow()
+ * after the last row. Only the cells in [0, rows) x [0, cols) hold
+ * constructed objects.
+ *
+ * Like DynamicArray, the memory comes from `Allocator`.
+ *
+ * NOTE: A Matrix is also the simplest MatrixExpression, so that `A + B * 2`
+ * works on matrices - see MatrixExpression.h.
+ * Blocks, the transpose, rows and columns can be used in place, without
+ * copying, through views - see MatrixView.h.
+ */
+template <typename T, typename Allocator = MallocAllocator>
+class Matrix : public MatrixExpression<Matrix<T, Allocator>>
+{
+private: // Note: private by default, no need to specify.
+	T* data;
+	unsigned cols, rows;
+
+	unsigned stride;      // Allocated columns per row. cols <= stride.
+	unsigned rowCapacity; // Allocated rows. rows <= rowCapacity.
+
+	Allocator allocator;
+
+	using Ops = Elements<T>;
+
+	// NOTE: The index and size math is done in size_t: in unsigned,
+	// row * stride and rows * cols overflow at 4G cells (e.g. 65536 x 65536).
+	T* cell(size_t row, size_t col) const { return data + row * stride + col; }
+
+	T* allocate(size_t cells)
+	{
+		if (!cells) return nullptr;
+		T* p = static_cast<T*>(
+		    allocator.allocate(cells * sizeof(T), alignof(T)));
+		traceAllocate<Matrix>(p, cells * sizeof(T));
+		return p;
+	}
+
+	void deallocate(T* p, size_t cells)
+	{
+		if (!p) return;
+		traceDeallocate<Matrix>(p, cells * sizeof(T));
+		allocator.deallocate(p, cells * sizeof(T));
+	}
+
+	void destroyAll()
+	{
+		for (unsigned i = 0; i < rows; ++i) {
+			Ops::destroy(cell(i, 0), cell(i, cols));
+		}
+	}
+
+	// Value-initializes (T{}) the cells [row, row + 1) x [from, to). If a
+	// constructor throws, the cells made so far are destroyed.
+	void constructCells(unsigned row, unsigned from, unsigned to)
+	{
+		unsigned j = from;
+		try {
+			for (; j < to; ++j)
+				new (cell(row, j)) T();
+		} catch (...) {
+			Ops::destroy(cell(row, from), cell(row, j));
+			throw;
+		}
+	}
+
+	/*
+	 * Moves the matrix into a block with the given capacities. Every row is
+	 * moved as a whole; when the stride stays the same and T is trivially
+	 * copyable, the allocator may even grow the block in place.
+	 */
+	void reallocate(unsigned newRowCapacity, unsigned newStride)
+	{
+		if constexpr (Ops::isTrivial) {
+			if (newStride == stride && data) {
+				AllocationStats* traced = traceReallocating<Matrix>(data);
+				T* resized = static_cast<T*>(allocator.reallocate(
+				    data, size_t(rowCapacity) * stride * sizeof(T),
+				    size_t(newRowCapacity) * newStride * sizeof(T),
+				    alignof(T)));
+				traceReallocate<Matrix>(
+				    traced, resized, size_t(rowCapacity) * stride * sizeof(T),
+				    size_t(newRowCapacity) * newStride * sizeof(T));
+				data = resized;
+				rowCapacity = newRowCapacity;
+				return;
+			}
+		}
+
+		T* resized = allocate(size_t(newRowCapacity) * newStride);
+		unsigned i = 0;
+		try {
+			for (; i < rows; ++i)
+				Ops::moveInto(resized + size_t(i) * newStride, cell(i, 0),
+				              cols);
+		} catch (...) {
+			for (unsigned k = 0; k < i; ++k)
+				Ops::destroy(resized + size_t(k) * newStride,
+				             resized + size_t(k) * newStride + cols);
+			deallocate(resized, size_t(newRowCapacity) * newStride);
+			throw;
+		}
+
+		destroyAll();
+		deallocate(data, size_t(rowCapacity) * stride);
+		data = resized;
+		rowCapacity = newRowCapacity;
+		stride = newStride;
+	}
+
+	static unsigned grown(unsigned capacity)
+	{
+		return capacity ? capacity * 2 : 4;
+	}
+
+	// Computes every element of `e` into this matrix, in a single pass.
+	// NOTE: `e` may read this matrix only as itself, element (i, j) for
+	// element (i, j) - see aliases() in MatrixExpression.h.
+	template <typename E> void evaluate(MatrixExpression<E> const& expression)
+	{
+		E const& e = expression.self();
+		for (unsigned i = 0; i < rows; ++i) {
+			T* dst = row(i);
+			for (unsigned j = 0; j < cols; ++j)
+				dst[j] = e.at(i, j);
+		}
+	}
+
+public:
+	using Value = T;
+	static constexpr bool isMatrix = true;
+
+	Matrix(unsigned rows, unsigned cols,
+	       Allocator const& allocator = Allocator())
+	    // Init member fields. Note that cols{cols} works as expected - it
+	    // assigns the argument `cols` to `this->cols`.
+	    : data{nullptr}, cols{cols}, rows{0}, stride{cols}, rowCapacity{rows},
+	      allocator{allocator}
+	{
+		data = allocate(size_t(rows) * cols);
+		try {
+			for (; this->rows < rows; ++this->rows) {
+				constructCells(this->rows, 0, cols);
+			}
+		} catch (...) {
+			// NOTE: The destructor doesn't run for a constructor which
+			// throws; `this->rows` counts the rows made whole.
+			destroyAll();
+			deallocate(data, size_t(rowCapacity) * stride);
+			throw;
+		}
+	}
+
+	Matrix() : Matrix(0, 0) {}
+
+	explicit Matrix(Allocator const& allocator) : Matrix(0, 0, allocator) {}
+
+	// The copy is compact - no spare rows or columns.
+	Matrix(Matrix const& other)
+	    : data{nullptr}, cols{other.cols}, rows{0}, stride{other.cols},
+	      rowCapacity{other.rows}, allocator{other.allocator}
+	{
+		data = allocate(size_t(rowCapacity) * stride);
+		try {
+			for (; rows < other.rows; ++rows) {
+				Ops::copyInto(cell(rows, 0), other.cell(rows, 0), cols);
+			}
+		} catch (...) {
+			destroyAll();
+			deallocate(data, size_t(rowCapacity) * stride);
+			throw;
+		}
+	}
+
+	// Evaluates a whole expression like `A + B * 2 - C` in one loop, without
+	// temporary matrices.
+	template <typename E>
+	Matrix(MatrixExpression<E> const& expression,
+	       Allocator const& allocator = Allocator())
+	    : Matrix(expression.getRows(), expression.getCols(), allocator)
+	{
+		evaluate(expression);
+	}
+
+	Matrix(Matrix&& other) noexcept
+	    : data{other.data}, cols{other.cols}, rows{other.rows},
+	      stride{other.stride}, rowCapacity{other.rowCapacity},
+	      allocator{other.allocator}
+	{
+		other.data = nullptr;
+		other.rows = other.cols = other.stride = other.rowCapacity = 0;
+	}
+
+	// Copy-and-swap, like in DynamicArray.
+	Matrix& operator=(Matrix other) noexcept
+	{
+		std::swap(data, other.data);
+		std::swap(cols, other.cols);
+		std::swap(rows, other.rows);
+		std::swap(stride, other.stride);
+		std::swap(rowCapacity, other.rowCapacity);
+		std::swap(allocator, other.allocator);
+		return *this;
+	}
+
+	/*
+	 * Reuses the memory of this matrix if the size matches - unless the
+	 * expression reads this matrix in another layout (e.g.
+	 * `A = A.transposed()`): then it is computed into a new matrix first.
+	 */
+	template <typename E>
+	Matrix& operator=(MatrixExpression<E> const& expression)
+	{
+		EvaluationTarget target =
+		    EvaluationTarget::of(data, rows, cols, stride, 1);
+		if (expression.getRows() == rows && expression.getCols() == cols &&
+		    !expression.self().aliases(target))
+			evaluate(expression);
+		else
+			*this = Matrix(expression, allocator);
+		return *this;
+	}
+
+	unsigned getRows() const { return rows; }
+	unsigned getCols() const { return cols; }
+
+	// Where the memory comes from, e.g. to allocate a result matrix.
+	Allocator const& getAllocator() const { return allocator; }
+
+	// Distance (in elements) between the starts of two consecutive rows.
+	unsigned getStride() const { return stride; }
+
+	// The raw storage, e.g. for kernels that walk the rows themselves.
+	// NOTE: Row `i` starts at getData() + i * getStride().
+	T* getData() { return data; }
+	T const* getData() const { return data; }
+
+	T* row(unsigned i) { return cell(i, 0); }
+	T const* row(unsigned i) const { return cell(i, 0); }
+
+	// NOTE: Return by reference!
+	T& get(int row, int col) { return *cell(row, col); }
+	T const& get(int row, int col) const { return *cell(row, col); }
+
+	// The element (i, j), as seen by MatrixExpression.
+	T const& at(unsigned i, unsigned j) const { return *cell(i, j); }
+
+	bool aliases(EvaluationTarget const& target) const
+	{
+		return storageAliases(target, data, rows, cols, stride, 1);
+	}
+
+	void set(int row, int col, T const& newValue)
+	{
+		*cell(row, col) = newValue;
+	}
+
+	// ---- Views (see MatrixView.h) ----------------------------------------
+
+	MatrixView<T> view() { return {data, rows, cols, stride}; }
+	MatrixView<T const> view() const { return {data, rows, cols, stride}; }
+
+	// The `rows` x `cols` block whose top left corner is (row, col).
+	MatrixView<T> block(unsigned row, unsigned col, unsigned rows,
+	                    unsigned cols)
+	{
+		return view().block(row, col, rows, cols);
+	}
+
+	MatrixView<T const> block(unsigned row, unsigned col, unsigned rows,
+	                          unsigned cols) const
+	{
+		return view().block(row, col, rows, cols);
+	}
+
+	MatrixView<T> transposed() { return view().transposed(); }
+	MatrixView<T const> transposed() const { return view().transposed(); }
+
+	VectorView<T> rowView(unsigned i) { return {row(i), cols, 1}; }
+	VectorView<T const> rowView(unsigned i) const { return {row(i), cols, 1}; }
+
+	VectorView<T> columnView(unsigned j) { return {data + j, rows, stride}; }
+	VectorView<T const> columnView(unsigned j) const
+	{
+		return {data + j, rows, stride};
+	}
+
+	// Makes room for at least `rows` x `cols` without further reallocation.
+	void reserve(unsigned rows, unsigned cols)
+	{
+		if (rows > rowCapacity || cols > stride)
+			reallocate(rows > rowCapacity ? rows : rowCapacity,
+			           cols > stride ? cols : stride);
+	}
+
+	/*
+	 * Adds a row of T{} at the bottom. Amortized O(cols): the row capacity
+	 * doubles when it runs out, like DynamicArray::push().
+	 */
+	void addRow()
+	{
+		if (rows == rowCapacity) reallocate(grown(rowCapacity), stride);
+
+		constructCells(rows, 0, cols);
+		rows++;
+	}
+
+	/*
+	 * Adds a column of T{} on the right. Amortized O(rows): the stride
+	 * doubles when there are no spare columns left.
+	 */
+	void addColumn()
+	{
+		if (cols == stride) reallocate(rowCapacity, grown(stride));
+
+		unsigned i = 0;
+		try {
+			for (; i < rows; ++i) {
+				constructCells(i, cols, cols + 1);
+			}
+		} catch (...) {
+			for (unsigned k = 0; k < i; ++k)
+				Ops::destroy(cell(k, cols), cell(k, cols + 1));
+			throw;
+		}
+		cols++;
+	}
+
+	~Matrix()
+	{
+		destroyAll();
+		deallocate(data, size_t(rowCapacity) * stride);
+	}
+};
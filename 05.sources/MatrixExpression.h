@@ -0,0 +1,233 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+
+/*
+ * Expression templates: lazy, fused arithmetic on matrices.
+ *
+ * With plain operators, `A + B * 2 - C` would create a temporary matrix for
+ * `B * 2`, another one for `A + (B * 2)` and a third one for the result -
+ * three allocations and five sweeps over memory. Here the operators don't
+ * compute anything. They only build a small object describing the expression,
+ * whose *type* is the expression tree:
+ *
+ *     Binary<Binary<Matrix, Scaled<Matrix, Multiply>, Plus>, Matrix, Minus>
+ *
+ * The work happens when it is assigned to a Matrix: a single loop computes
+ * every element of the result directly from A, B and C, with no temporaries.
+ *
+ * NOTE: Only element-wise operations can be fused like this. The matrix
+ * product is not one of them - see multiply() in MatrixMultiply.h.
+ * NOTE: An expression keeps references to the matrices in it - don't store
+ * it in a variable which outlives them (e.g. with `auto e = A + B;`).
+ *
+ * Computing an expression into a matrix it reads is fine as long as element
+ * (i, j) only reads the matrix's own element (i, j): `A = A * 2 + B`. A
+ * view which reads it in another layout is not - `A = A.transposed()` would
+ * read cells it has already overwritten. So every expression can tell,
+ * with aliases(target), whether it reads the target in another layout; see
+ * Matrix::operator=.
+ */
+
+/*
+ * The cells an expression is computed into: element (i, j) at the address
+ * data + i * rowStride + j * colStride (strides in bytes), all of them in
+ * [begin, end).
+ */
+struct EvaluationTarget
+{
+	std::uintptr_t begin, end;
+	std::uintptr_t data;
+	std::size_t rowStride, colStride;
+
+	// `rows` x `cols` elements at `data`, the strides counted in elements.
+	template <typename T>
+	static EvaluationTarget of(T const* data, unsigned rows, unsigned cols,
+	                           std::size_t rowStride, std::size_t colStride)
+	{
+		std::uintptr_t first = reinterpret_cast<std::uintptr_t>(data);
+		std::size_t span = rows && cols ? (rows - 1) * rowStride +
+		                                      (cols - 1) * colStride + 1
+		                                : 0;
+		return {first, first + span * sizeof(T), first,
+		        rowStride * sizeof(T), colStride * sizeof(T)};
+	}
+};
+
+/*
+ * aliases() of a matrix or a view: whether its elements - laid out as in
+ * EvaluationTarget::of() - share memory with `target` in another layout.
+ */
+template <typename T>
+bool storageAliases(EvaluationTarget const& target, T const* data,
+                    unsigned rows, unsigned cols, std::size_t rowStride,
+                    std::size_t colStride)
+{
+	EvaluationTarget self =
+	    EvaluationTarget::of(data, rows, cols, rowStride, colStride);
+	if (self.begin >= target.end || target.begin >= self.end) return false;
+
+	return self.data != target.data || self.rowStride != target.rowStride ||
+	       self.colStride != target.colStride;
+}
+
+// The base of every matrix expression, including Matrix itself. `E` is the
+// actual type (the "curiously recurring template pattern").
+template <typename E> struct MatrixExpression
+{
+	E const& self() const { return static_cast<E const&>(*this); }
+
+	unsigned getRows() const { return self().getRows(); }
+	unsigned getCols() const { return self().getCols(); }
+};
+
+// Matrices are kept by reference, intermediate expressions by value (they
+// are temporaries which die at the end of the full expression).
+template <typename E>
+using StoredExpression =
+    typename std::conditional<E::isMatrix, E const&, E const>::type;
+
+struct Plus
+{
+	template <typename T> static T apply(T const& a, T const& b) { return a + b; }
+};
+
+struct Minus
+{
+	template <typename T> static T apply(T const& a, T const& b) { return a - b; }
+};
+
+struct Multiply
+{
+	template <typename T> static T apply(T const& a, T const& b) { return a * b; }
+};
+
+struct Divide
+{
+	template <typename T> static T apply(T const& a, T const& b) { return a / b; }
+};
+
+// `l Op r`, element by element.
+template <typename L, typename R, typename Op>
+struct Binary : MatrixExpression<Binary<L, R, Op>>
+{
+	using Value = typename L::Value;
+	static constexpr bool isMatrix = false;
+
+	StoredExpression<L> l;
+	StoredExpression<R> r;
+
+	Binary(L const& l, R const& r) : l(l), r(r)
+	{
+		if (l.getRows() != r.getRows() || l.getCols() != r.getCols())
+			throw std::runtime_error("The matrices must be of the same size");
+	}
+
+	unsigned getRows() const { return l.getRows(); }
+	unsigned getCols() const { return l.getCols(); }
+
+	bool aliases(EvaluationTarget const& target) const
+	{
+		return l.aliases(target) || r.aliases(target);
+	}
+
+	Value at(unsigned i, unsigned j) const
+	{
+		return Op::apply(l.at(i, j), r.at(i, j));
+	}
+};
+
+// `e Op scalar`, or `scalar Op e` when `scalarFirst`, for every element.
+template <typename E, typename Op, bool scalarFirst = false>
+struct Scaled : MatrixExpression<Scaled<E, Op, scalarFirst>>
+{
+	using Value = typename E::Value;
+	static constexpr bool isMatrix = false;
+
+	StoredExpression<E> e;
+	Value scalar;
+
+	Scaled(E const& e, Value const& scalar) : e(e), scalar(scalar) {}
+
+	unsigned getRows() const { return e.getRows(); }
+	unsigned getCols() const { return e.getCols(); }
+
+	bool aliases(EvaluationTarget const& target) const
+	{
+		return e.aliases(target);
+	}
+
+	Value at(unsigned i, unsigned j) const
+	{
+		return scalarFirst ? Op::apply(scalar, e.at(i, j))
+		                   : Op::apply(e.at(i, j), scalar);
+	}
+};
+
+// `-e`
+template <typename E> struct Negated : MatrixExpression<Negated<E>>
+{
+	using Value = typename E::Value;
+	static constexpr bool isMatrix = false;
+
+	StoredExpression<E> e;
+
+	Negated(E const& e) : e(e) {}
+
+	unsigned getRows() const { return e.getRows(); }
+	unsigned getCols() const { return e.getCols(); }
+
+	bool aliases(EvaluationTarget const& target) const
+	{
+		return e.aliases(target);
+	}
+
+	Value at(unsigned i, unsigned j) const { return -e.at(i, j); }
+};
+
+template <typename L, typename R>
+Binary<L, R, Plus> operator+(MatrixExpression<L> const& l,
+                             MatrixExpression<R> const& r)
+{
+	return {l.self(), r.self()};
+}
+
+template <typename L, typename R>
+Binary<L, R, Minus> operator-(MatrixExpression<L> const& l,
+                              MatrixExpression<R> const& r)
+{
+	return {l.self(), r.self()};
+}
+
+template <typename E>
+Negated<E> operator-(MatrixExpression<E> const& e)
+{
+	return {e.self()};
+}
+
+// NOTE: `typename E::Value` is not deduced - E comes from the other
+// argument, and the scalar is converted to the element type (e.g. the `2`
+// in `B * 2` for a Matrix<double>).
+template <typename E>
+Scaled<E, Multiply> operator*(MatrixExpression<E> const& e,
+                              typename E::Value const& scalar)
+{
+	return {e.self(), scalar};
+}
+
+template <typename E>
+Scaled<E, Multiply, true> operator*(typename E::Value const& scalar,
+                                    MatrixExpression<E> const& e)
+{
+	return {e.self(), scalar};
+}
+
+template <typename E>
+Scaled<E, Divide> operator/(MatrixExpression<E> const& e,
+                            typename E::Value const& scalar)
+{
+	return {e.self(), scalar};
+}
@@ -0,0 +1,321 @@
+#pragma once
+
+#include "DynamicArray.h"
+#include "Matrix.h"
+#include "Simd.h"
+#include <stdexcept>
+
+/*
+ * Matrix multiplication C = A * B.
+ *
+ * The naive triple loop reads B column by column, which jumps a whole row
+ * ahead in memory on every step, and it reloads every element of A and B
+ * from memory about n times. multiply() instead follows the classic
+ * "GotoBLAS" scheme:
+ *
+ *  1. Cache blocking: the work is split into blocks of KC x NC of B and
+ *     MC x KC of A, small enough to stay in the caches while they are reused.
+ *  2. Packing: each block is copied into a buffer in exactly the order the
+ *     inner loop reads it, so that it walks memory strictly forward.
+ *  3. Register blocking: the innermost "micro-kernel" keeps an MR x W tile of
+ *     C in CPU registers for the whole KC loop, and only then adds it to C.
+ *  4. SIMD: for float and double the micro-kernel uses SSE or AVX2/FMA
+ *     instructions, chosen at run time depending on what the CPU supports.
+ *     Every other type uses a plain C++ micro-kernel.
+ */
+
+/*
+ * Micro-kernels. Each of them computes
+ *     C[0, MR) x [0, W) += packedA * packedB
+ * where packedA holds `kc` columns of MR values (A[r][k] at k * MR + r) and
+ * packedB holds `kc` rows of W values (B[k][j] at k * W + j).
+ */
+template <typename T> struct ScalarKernel
+{
+	static constexpr unsigned MR = 4, W = 4;
+
+	static void run(unsigned kc, T const* pa, T const* pb, T* c, unsigned ldc)
+	{
+		T acc[MR][W] = {};
+		for (unsigned k = 0; k < kc; ++k) {
+			for (unsigned r = 0; r < MR; ++r) {
+				for (unsigned j = 0; j < W; ++j) {
+					acc[r][j] += pa[k * MR + r] * pb[k * W + j];
+				}
+			}
+		}
+
+		for (unsigned r = 0; r < MR; ++r) {
+			for (unsigned j = 0; j < W; ++j) {
+				c[r * ldc + j] += acc[r][j];
+			}
+		}
+	}
+};
+
+#ifdef X86_SIMD
+
+// NOTE: 6 x 2 accumulators + 2 for B + 1 for A = 15 of the 16 SSE registers.
+struct SseFloatKernel
+{
+	static constexpr unsigned MR = 6, W = 8;
+
+	__attribute__((target("sse2"))) static void
+	run(unsigned kc, float const* pa, float const* pb, float* c, unsigned ldc)
+	{
+		__m128 acc[MR][2];
+		for (unsigned r = 0; r < MR; ++r)
+			acc[r][0] = acc[r][1] = _mm_setzero_ps();
+
+		for (unsigned k = 0; k < kc; ++k, pa += MR, pb += W) {
+			__m128 b0 = _mm_loadu_ps(pb), b1 = _mm_loadu_ps(pb + 4);
+			for (unsigned r = 0; r < MR; ++r) {
+				__m128 a = _mm_set1_ps(pa[r]);
+				acc[r][0] = _mm_add_ps(acc[r][0], _mm_mul_ps(a, b0));
+				acc[r][1] = _mm_add_ps(acc[r][1], _mm_mul_ps(a, b1));
+			}
+		}
+
+		for (unsigned r = 0; r < MR; ++r, c += ldc) {
+			_mm_storeu_ps(c, _mm_add_ps(_mm_loadu_ps(c), acc[r][0]));
+			_mm_storeu_ps(c + 4, _mm_add_ps(_mm_loadu_ps(c + 4), acc[r][1]));
+		}
+	}
+};
+
+struct SseDoubleKernel
+{
+	static constexpr unsigned MR = 6, W = 4;
+
+	__attribute__((target("sse2"))) static void
+	run(unsigned kc, double const* pa, double const* pb, double* c,
+	    unsigned ldc)
+	{
+		__m128d acc[MR][2];
+		for (unsigned r = 0; r < MR; ++r)
+			acc[r][0] = acc[r][1] = _mm_setzero_pd();
+
+		for (unsigned k = 0; k < kc; ++k, pa += MR, pb += W) {
+			__m128d b0 = _mm_loadu_pd(pb), b1 = _mm_loadu_pd(pb + 2);
+			for (unsigned r = 0; r < MR; ++r) {
+				__m128d a = _mm_set1_pd(pa[r]);
+				acc[r][0] = _mm_add_pd(acc[r][0], _mm_mul_pd(a, b0));
+				acc[r][1] = _mm_add_pd(acc[r][1], _mm_mul_pd(a, b1));
+			}
+		}
+
+		for (unsigned r = 0; r < MR; ++r, c += ldc) {
+			_mm_storeu_pd(c, _mm_add_pd(_mm_loadu_pd(c), acc[r][0]));
+			_mm_storeu_pd(c + 2, _mm_add_pd(_mm_loadu_pd(c + 2), acc[r][1]));
+		}
+	}
+};
+
+// NOTE: The same register budget, with twice as wide registers.
+struct AvxFloatKernel
+{
+	static constexpr unsigned MR = 6, W = 16;
+
+	__attribute__((target("avx2,fma"))) static void
+	run(unsigned kc, float const* pa, float const* pb, float* c, unsigned ldc)
+	{
+		__m256 acc[MR][2];
+		for (unsigned r = 0; r < MR; ++r)
+			acc[r][0] = acc[r][1] = _mm256_setzero_ps();
+
+		for (unsigned k = 0; k < kc; ++k, pa += MR, pb += W) {
+			__m256 b0 = _mm256_loadu_ps(pb), b1 = _mm256_loadu_ps(pb + 8);
+			for (unsigned r = 0; r < MR; ++r) {
+				__m256 a = _mm256_broadcast_ss(pa + r);
+				acc[r][0] = _mm256_fmadd_ps(a, b0, acc[r][0]);
+				acc[r][1] = _mm256_fmadd_ps(a, b1, acc[r][1]);
+			}
+		}
+
+		for (unsigned r = 0; r < MR; ++r, c += ldc) {
+			_mm256_storeu_ps(c, _mm256_add_ps(_mm256_loadu_ps(c), acc[r][0]));
+			_mm256_storeu_ps(c + 8,
+			                 _mm256_add_ps(_mm256_loadu_ps(c + 8), acc[r][1]));
+		}
+	}
+};
+
+struct AvxDoubleKernel
+{
+	static constexpr unsigned MR = 6, W = 8;
+
+	__attribute__((target("avx2,fma"))) static void
+	run(unsigned kc, double const* pa, double const* pb, double* c,
+	    unsigned ldc)
+	{
+		__m256d acc[MR][2];
+		for (unsigned r = 0; r < MR; ++r)
+			acc[r][0] = acc[r][1] = _mm256_setzero_pd();
+
+		for (unsigned k = 0; k < kc; ++k, pa += MR, pb += W) {
+			__m256d b0 = _mm256_loadu_pd(pb), b1 = _mm256_loadu_pd(pb + 4);
+			for (unsigned r = 0; r < MR; ++r) {
+				__m256d a = _mm256_broadcast_sd(pa + r);
+				acc[r][0] = _mm256_fmadd_pd(a, b0, acc[r][0]);
+				acc[r][1] = _mm256_fmadd_pd(a, b1, acc[r][1]);
+			}
+		}
+
+		for (unsigned r = 0; r < MR; ++r, c += ldc) {
+			_mm256_storeu_pd(c, _mm256_add_pd(_mm256_loadu_pd(c), acc[r][0]));
+			_mm256_storeu_pd(c + 4,
+			                 _mm256_add_pd(_mm256_loadu_pd(c + 4), acc[r][1]));
+		}
+	}
+};
+
+#endif
+
+/*
+ * The blocked, packed driver around a micro-kernel. Computes
+ *     C[M x N] += A[M x K] * B[K x N]
+ * where row i of X starts at x + i * ldx.
+ */
+template <typename T, typename Kernel>
+void multiplyBlocked(T const* a, unsigned lda, T const* b, unsigned ldb, T* c,
+                     unsigned ldc, unsigned M, unsigned N, unsigned K)
+{
+	constexpr unsigned MR = Kernel::MR, W = Kernel::W;
+
+	// Block sizes: a KC x W panel of B stays in L1, an MC x KC block of A in
+	// L2, and a KC x NC block of B in L3.
+	constexpr unsigned KC = 256, MC = MR * 16, NC = W * 64;
+
+	DynamicArray<T> packedA(MC * KC), packedB(NC * KC);
+	T tile[MR * W];
+
+	for (unsigned jc = 0; jc < N; jc += NC) {
+		unsigned nc = N - jc < NC ? N - jc : NC;
+
+		for (unsigned pc = 0; pc < K; pc += KC) {
+			unsigned kc = K - pc < KC ? K - pc : KC;
+
+			// Pack B[pc, pc + kc) x [jc, jc + nc) into panels of W columns,
+			// padding the last one with zeros.
+			for (unsigned jp = 0; jp < nc; jp += W) {
+				T* panel = &packedB[jp * kc];
+				for (unsigned k = 0; k < kc; ++k) {
+					T const* src = b + (pc + k) * ldb + jc + jp;
+					for (unsigned j = 0; j < W; ++j)
+						panel[k * W + j] = jp + j < nc ? src[j] : T{};
+				}
+			}
+
+			for (unsigned ic = 0; ic < M; ic += MC) {
+				unsigned mc = M - ic < MC ? M - ic : MC;
+
+				// Pack A[ic, ic + mc) x [pc, pc + kc) into panels of MR
+				// rows, stored column by column.
+				for (unsigned ip = 0; ip < mc; ip += MR) {
+					T* panel = &packedA[ip * kc];
+					for (unsigned k = 0; k < kc; ++k) {
+						for (unsigned r = 0; r < MR; ++r) {
+							panel[k * MR + r] =
+							    ip + r < mc ? a[(ic + ip + r) * lda + pc + k]
+							                : T{};
+						}
+					}
+				}
+
+				for (unsigned jp = 0; jp < nc; jp += W) {
+					for (unsigned ip = 0; ip < mc; ip += MR) {
+						T const* pa = &packedA[ip * kc];
+						T const* pb = &packedB[jp * kc];
+						T* cij = c + (ic + ip) * ldc + jc + jp;
+
+						if (ip + MR <= mc && jp + W <= nc) {
+							Kernel::run(kc, pa, pb, cij, ldc);
+							continue;
+						}
+
+						// An edge tile: compute it on the side, then add
+						// only the part that is inside C.
+						for (unsigned t = 0; t < MR * W; ++t)
+							tile[t] = T{};
+						Kernel::run(kc, pa, pb, tile, W);
+
+						for (unsigned r = 0; r < MR && ip + r < mc; ++r) {
+							for (unsigned j = 0; j < W && jp + j < nc; ++j) {
+								cij[r * ldc + j] += tile[r * W + j];
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+// Picks the micro-kernel for T and the given instruction set.
+template <typename T>
+void multiplyInto(T const* a, unsigned lda, T const* b, unsigned ldb, T* c,
+                  unsigned ldc, unsigned M, unsigned N, unsigned K,
+                  SimdLevel level)
+{
+#ifdef X86_SIMD
+	if constexpr (std::is_same<T, float>::value) {
+		if (level == SimdLevel::AVX2)
+			return multiplyBlocked<float, AvxFloatKernel>(a, lda, b, ldb, c,
+			                                              ldc, M, N, K);
+		if (level == SimdLevel::SSE)
+			return multiplyBlocked<float, SseFloatKernel>(a, lda, b, ldb, c,
+			                                              ldc, M, N, K);
+	}
+	if constexpr (std::is_same<T, double>::value) {
+		if (level == SimdLevel::AVX2)
+			return multiplyBlocked<double, AvxDoubleKernel>(a, lda, b, ldb, c,
+			                                                ldc, M, N, K);
+		if (level == SimdLevel::SSE)
+			return multiplyBlocked<double, SseDoubleKernel>(a, lda, b, ldb, c,
+			                                                ldc, M, N, K);
+	}
+#endif
+	(void)level;
+	multiplyBlocked<T, ScalarKernel<T>>(a, lda, b, ldb, c, ldc, M, N, K);
+}
+
+/*
+ * Returns the product `a * b`. Throws if `a` has a different number of
+ * columns than `b` has rows.
+ * NOTE: `level` is there mostly for benchmarks - by default we use the best
+ * one the CPU supports.
+ */
+template <typename T, typename Allocator>
+Matrix<T, Allocator> multiply(Matrix<T, Allocator> const& a,
+                              Matrix<T, Allocator> const& b,
+                              SimdLevel level = detectSimdLevel())
+{
+	if (a.getCols() != b.getRows())
+		throw std::runtime_error("Can't multiply matrices of these sizes");
+
+	Matrix<T, Allocator> result{a.getRows(), b.getCols(), a.getAllocator()};
+	multiplyInto(a.getData(), a.getStride(), b.getData(), b.getStride(),
+	             result.getData(), result.getStride(), a.getRows(),
+	             b.getCols(), a.getCols(), level);
+	return result;
+}
+
+// The textbook triple loop, for comparison.
+template <typename T, typename Allocator>
+Matrix<T, Allocator> multiplyNaive(Matrix<T, Allocator> const& a,
+                                   Matrix<T, Allocator> const& b)
+{
+	if (a.getCols() != b.getRows())
+		throw std::runtime_error("Can't multiply matrices of these sizes");
+
+	Matrix<T, Allocator> result{a.getRows(), b.getCols(), a.getAllocator()};
+	for (unsigned i = 0; i < a.getRows(); ++i) {
+		for (unsigned j = 0; j < b.getCols(); ++j) {
+			T sum{};
+			for (unsigned k = 0; k < a.getCols(); ++k)
+				sum += a.get(i, k) * b.get(k, j);
+			result.set(i, j, sum);
+		}
+	}
+	return result;
+}
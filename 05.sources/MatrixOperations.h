@@ -0,0 +1,308 @@
+#pragma once
+
+#include "DynamicArray.h"
+#include "Matrix.h"
+#include "MatrixMultiply.h"
+#include "ThreadPool.h"
+#include <cmath>
+#include <stdexcept>
+
+/*
+ * Element-wise operations, transposition, reductions and multiplication of
+ * matrices. Each comes in two flavours:
+ *     add(a, b)        - on the calling thread
+ *     add(a, b, pool)  - split by blocks of rows over a ThreadPool
+ *
+ * NOTE: The rows are split into blocks of a *fixed* size, independent of the
+ * number of threads, and reductions combine the per-block results in block
+ * order. So the parallel versions give exactly the same bits as the serial
+ * ones - for floating point numbers too - no matter how many threads run.
+ */
+
+// Rows per block. Big enough to amortize the scheduling, small enough to
+// balance the load.
+const unsigned ROW_BLOCK = 16;
+
+inline unsigned rowBlocks(unsigned rows)
+{
+	return (rows + ROW_BLOCK - 1) / ROW_BLOCK;
+}
+
+/*
+ * Calls `f(begin, end)` for each block of rows [begin, end) - on `pool`, or
+ * on the calling thread when `pool` is null.
+ */
+template <typename F>
+void forEachRowBlock(unsigned rows, ThreadPool* pool, F const& f)
+{
+	auto block = [&](unsigned b) {
+		unsigned begin = b * ROW_BLOCK;
+		unsigned end = begin + ROW_BLOCK < rows ? begin + ROW_BLOCK : rows;
+		f(begin, end);
+	};
+
+	if (pool)
+		pool->parallelFor(rowBlocks(rows), block);
+	else
+		for (unsigned b = 0; b < rowBlocks(rows); ++b)
+			block(b);
+}
+
+/*
+ * Reduces every block of rows to one value with `reduceRows(begin, end)`,
+ * then folds the block results in order with `combine`.
+ */
+template <typename R, typename ReduceRows, typename Combine>
+R reduceRowBlocks(unsigned rows, ThreadPool* pool, R initial,
+                  ReduceRows const& reduceRows, Combine const& combine)
+{
+	DynamicArray<R> partial(rowBlocks(rows));
+	forEachRowBlock(rows, pool, [&](unsigned begin, unsigned end) {
+		partial[begin / ROW_BLOCK] = reduceRows(begin, end);
+	});
+
+	R result = initial;
+	for (unsigned b = 0; b < partial.getSize(); ++b)
+		result = combine(result, partial[b]);
+	return result;
+}
+
+template <typename T, typename A>
+void requireSameSize(Matrix<T, A> const& a, Matrix<T, A> const& b)
+{
+	if (a.getRows() != b.getRows() || a.getCols() != b.getCols())
+		throw std::runtime_error("The matrices must be of the same size");
+}
+
+template <typename T, typename A>
+void requireNonEmpty(Matrix<T, A> const& m)
+{
+	if (!m.getRows() || !m.getCols())
+		throw std::runtime_error("The matrix is empty");
+}
+
+// ---- Element-wise ---------------------------------------------------------
+
+// A new matrix with f(x) for every element x of `m`.
+template <typename T, typename A, typename F>
+Matrix<T, A> map(Matrix<T, A> const& m, F const& f, ThreadPool* pool = nullptr)
+{
+	Matrix<T, A> result{m.getRows(), m.getCols(), m.getAllocator()};
+	forEachRowBlock(m.getRows(), pool, [&](unsigned begin, unsigned end) {
+		for (unsigned i = begin; i < end; ++i) {
+			T const* src = m.row(i);
+			T* dst = result.row(i);
+			for (unsigned j = 0; j < m.getCols(); ++j)
+				dst[j] = f(src[j]);
+		}
+	});
+	return result;
+}
+
+template <typename T, typename A, typename F>
+Matrix<T, A> map(Matrix<T, A> const& m, F const& f, ThreadPool& pool)
+{
+	return map(m, f, &pool);
+}
+
+template <typename T, typename A>
+Matrix<T, A> add(Matrix<T, A> const& a, Matrix<T, A> const& b,
+                 ThreadPool* pool = nullptr)
+{
+	requireSameSize(a, b);
+
+	Matrix<T, A> result{a.getRows(), a.getCols(), a.getAllocator()};
+	forEachRowBlock(a.getRows(), pool, [&](unsigned begin, unsigned end) {
+		for (unsigned i = begin; i < end; ++i) {
+			T const *x = a.row(i), *y = b.row(i);
+			T* dst = result.row(i);
+			for (unsigned j = 0; j < a.getCols(); ++j)
+				dst[j] = x[j] + y[j];
+		}
+	});
+	return result;
+}
+
+template <typename T, typename A>
+Matrix<T, A> add(Matrix<T, A> const& a, Matrix<T, A> const& b,
+                 ThreadPool& pool)
+{
+	return add(a, b, &pool);
+}
+
+template <typename T, typename A>
+Matrix<T, A> scale(Matrix<T, A> const& m, T const& factor,
+                   ThreadPool* pool = nullptr)
+{
+	return map(m, [&](T const& x) { return x * factor; }, pool);
+}
+
+template <typename T, typename A>
+Matrix<T, A> scale(Matrix<T, A> const& m, T const& factor, ThreadPool& pool)
+{
+	return scale(m, factor, &pool);
+}
+
+// ---- Transposition --------------------------------------------------------
+
+/*
+ * NOTE: Each block of rows of the *result* is a block of columns of `m`.
+ * We read `m` in small square tiles, so that the cache lines loaded while
+ * walking down a column are reused for the next few columns.
+ */
+template <typename T, typename A>
+Matrix<T, A> transpose(Matrix<T, A> const& m, ThreadPool* pool = nullptr)
+{
+	const unsigned TILE = 16;
+	Matrix<T, A> result{m.getCols(), m.getRows(), m.getAllocator()};
+
+	forEachRowBlock(m.getCols(), pool, [&](unsigned begin, unsigned end) {
+		for (unsigned i0 = 0; i0 < m.getRows(); i0 += TILE) {
+			unsigned i1 = i0 + TILE < m.getRows() ? i0 + TILE : m.getRows();
+			for (unsigned j = begin; j < end; ++j) {
+				T* dst = result.row(j);
+				for (unsigned i = i0; i < i1; ++i)
+					dst[i] = m.get(i, j);
+			}
+		}
+	});
+	return result;
+}
+
+template <typename T, typename A>
+Matrix<T, A> transpose(Matrix<T, A> const& m, ThreadPool& pool)
+{
+	return transpose(m, &pool);
+}
+
+// ---- Reductions -----------------------------------------------------------
+
+template <typename T, typename A>
+T sum(Matrix<T, A> const& m, ThreadPool* pool = nullptr)
+{
+	return reduceRowBlocks(
+	    m.getRows(), pool, T{},
+	    [&](unsigned begin, unsigned end) {
+		    T s{};
+		    for (unsigned i = begin; i < end; ++i)
+			    for (unsigned j = 0; j < m.getCols(); ++j)
+				    s += m.row(i)[j];
+		    return s;
+	    },
+	    [](T const& x, T const& y) { return x + y; });
+}
+
+template <typename T, typename A> T sum(Matrix<T, A> const& m, ThreadPool& pool)
+{
+	return sum(m, &pool);
+}
+
+// Folds the elements with `pick(x, y)`, e.g. returning the smaller one.
+template <typename T, typename A, typename Pick>
+T foldElements(Matrix<T, A> const& m, ThreadPool* pool, Pick const& pick)
+{
+	requireNonEmpty(m);
+
+	return reduceRowBlocks(
+	    m.getRows(), pool, m.get(0, 0),
+	    [&](unsigned begin, unsigned end) {
+		    T result = m.get(begin, 0);
+		    for (unsigned i = begin; i < end; ++i)
+			    for (unsigned j = 0; j < m.getCols(); ++j)
+				    result = pick(result, m.row(i)[j]);
+		    return result;
+	    },
+	    pick);
+}
+
+template <typename T, typename A>
+T min(Matrix<T, A> const& m, ThreadPool* pool = nullptr)
+{
+	return foldElements(m, pool,
+	                    [](T const& x, T const& y) { return y < x ? y : x; });
+}
+
+template <typename T, typename A> T min(Matrix<T, A> const& m, ThreadPool& pool)
+{
+	return min(m, &pool);
+}
+
+template <typename T, typename A>
+T max(Matrix<T, A> const& m, ThreadPool* pool = nullptr)
+{
+	return foldElements(m, pool,
+	                    [](T const& x, T const& y) { return x < y ? y : x; });
+}
+
+template <typename T, typename A> T max(Matrix<T, A> const& m, ThreadPool& pool)
+{
+	return max(m, &pool);
+}
+
+// The biggest absolute value of an element (the "max norm").
+template <typename T, typename A>
+T normMax(Matrix<T, A> const& m, ThreadPool* pool = nullptr)
+{
+	return foldElements(m, pool, [](T const& x, T const& y) {
+		T absX = x < T{} ? -x : x, absY = y < T{} ? -y : y;
+		return absX < absY ? absY : absX;
+	});
+}
+
+template <typename T, typename A>
+T normMax(Matrix<T, A> const& m, ThreadPool& pool)
+{
+	return normMax(m, &pool);
+}
+
+// The square root of the sum of squares of all elements.
+template <typename T, typename A>
+double normFrobenius(Matrix<T, A> const& m, ThreadPool* pool = nullptr)
+{
+	return std::sqrt(reduceRowBlocks(
+	    m.getRows(), pool, 0.0,
+	    [&](unsigned begin, unsigned end) {
+		    double s = 0;
+		    for (unsigned i = begin; i < end; ++i)
+			    for (unsigned j = 0; j < m.getCols(); ++j)
+				    s += double(m.row(i)[j]) * double(m.row(i)[j]);
+		    return s;
+	    },
+	    [](double x, double y) { return x + y; }));
+}
+
+template <typename T, typename A>
+double normFrobenius(Matrix<T, A> const& m, ThreadPool& pool)
+{
+	return normFrobenius(m, &pool);
+}
+
+// ---- Multiplication -------------------------------------------------------
+
+/*
+ * The same as multiply(a, b), with the rows of the result split over the
+ * pool. Every element of the result is computed in exactly the same order
+ * as in the serial version.
+ */
+template <typename T, typename A>
+Matrix<T, A> multiply(Matrix<T, A> const& a, Matrix<T, A> const& b,
+                      ThreadPool& pool, SimdLevel level = detectSimdLevel())
+{
+	if (a.getCols() != b.getRows())
+		throw std::runtime_error("Can't multiply matrices of these sizes");
+
+	Matrix<T, A> result{a.getRows(), b.getCols(), a.getAllocator()};
+
+	// Bigger blocks than ROW_BLOCK: each block packs its own copy of B.
+	const unsigned BLOCK = 96;
+	unsigned blocks = (a.getRows() + BLOCK - 1) / BLOCK;
+	pool.parallelFor(blocks, [&](unsigned block) {
+		unsigned begin = block * BLOCK;
+		unsigned rows = a.getRows() - begin < BLOCK ? a.getRows() - begin
+		                                            : BLOCK;
+		multiplyInto(a.row(begin), a.getStride(), b.getData(), b.getStride(),
+		             result.row(begin), result.getStride(), rows, b.getCols(),
+		             a.getCols(), level);
+	});
+	return result;
+}
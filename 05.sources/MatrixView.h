@@ -0,0 +1,166 @@
+#pragma once
+
+#include "MatrixExpression.h"
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+
+/*
+ * Non-owning views into the storage of a Matrix: a block (submatrix), the
+ * transpose, a single row or column. Nothing is copied - reading a view
+ * reads the matrix, and writing to a view writes to the matrix:
+ *
+ *     Matrix<float> m{1024, 1024};
+ *     auto tile = m.block(256, 512, 64, 64);   // rows 256..319, cols 512..575
+ *     tile.set(0, 0, 1);                       // m.get(256, 512) is now 1
+ *     tile = tile * 2;                         // doubles only those cells
+ *     m.transposed().get(3, 5);                // m.get(5, 3)
+ *
+ * Element (i, j) of a view is at data[i * rowStride + j * colStride]. A
+ * block of a matrix keeps the matrix's strides and moves `data`; the
+ * transpose just swaps the two strides. So views of views work the same
+ * way, e.g. a block of a transpose.
+ *
+ * NOTE: A view is invalidated by anything that reallocates the matrix -
+ * addRow(), addColumn(), reserve(), assigning a matrix of another size.
+ * NOTE: Assigning to a view copies *elements* into the viewed cells; it
+ * never rebinds the view. The right-hand side must not overlap the view
+ * in a different layout (e.g. `m.block(...) = m.transposed()...`), as the
+ * elements are written one by one while it is still being read.
+ *
+ * MatrixView<T const> is a read-only view, e.g. of a const Matrix.
+ */
+
+/*
+ * `size` elements, `stride` apart - a row or a column of a matrix.
+ */
+template <typename T> class VectorView
+{
+	T* data;
+	unsigned size;
+	unsigned stride;
+
+public:
+	VectorView(T* data, unsigned size, unsigned stride)
+	    : data{data}, size{size}, stride{stride}
+	{
+	}
+
+	unsigned getSize() const { return size; }
+	unsigned getStride() const { return stride; }
+
+	T& operator[](unsigned i) const { return data[size_t(i) * stride]; }
+};
+
+template <typename T>
+class MatrixView : public MatrixExpression<MatrixView<T>>
+{
+	T* data;
+	unsigned rows, cols;
+	unsigned rowStride, colStride;
+
+	using Mutable = typename std::remove_const<T>::type;
+
+	void requireInside(unsigned row, unsigned col, unsigned rows,
+	                   unsigned cols) const
+	{
+		if (row > this->rows || rows > this->rows - row || col > this->cols ||
+		    cols > this->cols - col)
+			throw std::runtime_error("The block is outside the matrix");
+	}
+
+	template <typename E> void assign(MatrixExpression<E> const& expression)
+	{
+		static_assert(!std::is_const<T>::value, "The view is read-only");
+
+		E const& e = expression.self();
+		if (e.getRows() != rows || e.getCols() != cols)
+			throw std::runtime_error("The matrices must be of the same size");
+
+		for (unsigned i = 0; i < rows; ++i)
+			for (unsigned j = 0; j < cols; ++j)
+				get(i, j) = e.at(i, j);
+	}
+
+public:
+	using Value = Mutable;
+	static constexpr bool isMatrix = true; // Kept by reference in expressions.
+
+	MatrixView(T* data, unsigned rows, unsigned cols, unsigned rowStride,
+	           unsigned colStride = 1)
+	    : data{data}, rows{rows}, cols{cols}, rowStride{rowStride},
+	      colStride{colStride}
+	{
+	}
+
+	// A writable view converts to a read-only one.
+	operator MatrixView<T const>() const
+	{
+		return {data, rows, cols, rowStride, colStride};
+	}
+
+	// Writes the elements of `other` into the cells of this view.
+	MatrixView& operator=(MatrixView const& other)
+	{
+		assign(other);
+		return *this;
+	}
+
+	// Writes every element of the expression into the cells of this view,
+	// e.g. `m.block(0, 0, 8, 8) = a.block(8, 8, 8, 8) * 2`.
+	template <typename E>
+	MatrixView& operator=(MatrixExpression<E> const& expression)
+	{
+		assign(expression);
+		return *this;
+	}
+
+	unsigned getRows() const { return rows; }
+	unsigned getCols() const { return cols; }
+
+	// Element (i, j) is at getData()[i * getRowStride() + j * getColStride()].
+	T* getData() const { return data; }
+	unsigned getRowStride() const { return rowStride; }
+	unsigned getColStride() const { return colStride; }
+
+	T& get(unsigned row, unsigned col) const
+	{
+		return data[size_t(row) * rowStride + size_t(col) * colStride];
+	}
+
+	T const& at(unsigned i, unsigned j) const { return get(i, j); }
+
+	bool aliases(EvaluationTarget const& target) const
+	{
+		return storageAliases(target, data, rows, cols, rowStride, colStride);
+	}
+
+	void set(unsigned row, unsigned col, Mutable const& newValue) const
+	{
+		get(row, col) = newValue;
+	}
+
+	// The `rows` x `cols` block whose top left corner is (row, col).
+	MatrixView block(unsigned row, unsigned col, unsigned rows,
+	                 unsigned cols) const
+	{
+		requireInside(row, col, rows, cols);
+		return {data + size_t(row) * rowStride + size_t(col) * colStride,
+		        rows, cols, rowStride, colStride};
+	}
+
+	MatrixView transposed() const
+	{
+		return {data, cols, rows, colStride, rowStride};
+	}
+
+	VectorView<T> rowView(unsigned i) const
+	{
+		return {data + size_t(i) * rowStride, cols, colStride};
+	}
+
+	VectorView<T> columnView(unsigned j) const
+	{
+		return {data + size_t(j) * colStride, rows, rowStride};
+	}
+};
@@ -1,20 +1,21 @@
 #include "Person.h"
 #include "City.h"
 
-void Person::update(float deltaTime)
+void Person::update(RandomStream& random)
 {
-	healthState.update(deltaTime);
-
 	if (loc.checkIfHome()) {
-		if (!healthState.hasSympoms && myrand() > 0.9)
-			loc.goOut({20, 20, rand() * 2 * PI});
+		if (!healthState.hasSympoms && bernoulli(random, 0.1f))
+			loc.goOut({20, 20, uniform(random) * 2 * PI});
 	} else { // if outside
 		loc.move(4);
 
-		if (rand() > 0.5) loc.goHome();
-
-		if (city.hasSickPeopleAround(loc.getPosition(), 10) && rand() > 0.3) {
-			healthState.infect();
-		}
+		// NOTE: Someone who went home has no position to check. Who was
+		// ill once is immune.
+		if (bernoulli(random, 0.5f))
+			loc.goHome();
+		else if (healthState.isHealthy() &&
+		         city.hasSickPeopleAround(loc.getPosition(), 10) &&
+		         bernoulli(random, 0.7f))
+			healthState.infect(city.time);
 	}
 }
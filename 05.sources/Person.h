@@ -1,27 +1,47 @@
 #pragma once
 
 #include "Position.h"
+#include "Random.h"
 #include <stdexcept>
 
+/*
+ * The course of an illness: infect() - INCUBATION time units without
+ * symptoms - ILLNESS time units with symptoms - recovered, and immune.
+ * The transitions happen at known times (`nextChange`), when City calls
+ * advance(); in between, nothing needs to be done (see City::update()).
+ */
 struct HealthState
 {
-	float timeIll;
+	unsigned infectedAt; // The City::time of the infection, unless HEALTHY.
 	bool hasSympoms;
 
 	enum { HEALTHY, ILL, RECOVERED } healthState;
 
-	void update(float deltaTime)
-	{
-		if (healthState == ILL) timeIll += deltaTime;
-	}
+	unsigned nextChange; // The time of the next transition, when ILL.
 
-	bool isHealthy() { return healthState == HEALTHY; }
+	static constexpr unsigned INCUBATION = 5;
+	static constexpr unsigned ILLNESS = 14;
 
-	void infect()
+	bool isHealthy() const { return healthState == HEALTHY; }
+
+	void infect(unsigned now)
 	{
 		healthState = ILL;
-		timeIll = 0;
+		infectedAt = now;
 		hasSympoms = false;
+		nextChange = now + INCUBATION;
+	}
+
+	// The transition due at `nextChange`: the symptoms start, or they pass.
+	void advance()
+	{
+		if (!hasSympoms) {
+			hasSympoms = true;
+			nextChange = infectedAt + INCUBATION + ILLNESS;
+		} else {
+			healthState = RECOVERED;
+			hasSympoms = false;
+		}
 	}
 };
 
@@ -66,9 +86,6 @@ public:
 	}
 };
 
-// 0 <= myrand() <= 1
-inline float myrand() { return 0.5; }
-
 struct City;
 
 struct Person
@@ -78,6 +95,9 @@ struct Person
 	PersonLocation loc;
 	HealthState healthState;
 
-	void update(float deltaTime);
+	// NOTE: Changes only this person, and takes every random number from
+	// `random` - see City::update(). The health transitions are up to City,
+	// so the length of the tick doesn't matter here.
+	void update(RandomStream& random);
 };
 
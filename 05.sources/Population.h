@@ -0,0 +1,359 @@
+#pragma once
+
+#include "DynamicArray.h"
+#include "Person.h"
+#include "Position.h"
+#include "Simd.h"
+#include <stdexcept>
+
+/*
+ * Proximity checks over batches of people, with their coordinates in two
+ * separate arrays: person i is at (x[i], y[i]).
+ *
+ *     distancesSquared(pos, x, y, n, out);  // out[i] = distanceSquared(..)
+ *     anyWithinRadius(pos, radius, x, y, n, accept);
+ *
+ * anyWithinRadius() is whether withinRadius(pos, person i, radius) for some
+ * person i with accept(i) - e.g. "is that person sick?". accept is only
+ * asked about the people within the radius, which are few, so the kernels
+ * can check 4 or 8 people per instruction and leave the rest to C++.
+ *
+ * The results are exactly those of distanceSquared() and withinRadius()
+ * in Position.h, whatever the SimdLevel: the kernels do the same float
+ * operations in the same order - in particular, without FMA, which would
+ * round differently.
+ */
+struct ScalarProximity
+{
+	static void distancesSquared(Position const& pos, float const* x,
+	                             float const* y, unsigned n, float* out)
+	{
+		for (unsigned i = 0; i < n; ++i)
+			out[i] = distanceSquared(pos, Position{x[i], y[i], 0});
+	}
+
+	template <typename Accept>
+	static bool anyWithinRadius(Position const& pos, float radius,
+	                            float const* x, float const* y, unsigned n,
+	                            Accept& accept)
+	{
+		for (unsigned i = 0; i < n; ++i)
+			if (withinRadius(pos, Position{x[i], y[i], 0}, radius) &&
+			    accept(i))
+				return true;
+		return false;
+	}
+};
+
+#ifdef X86_SIMD
+
+struct SseProximity
+{
+	__attribute__((target("sse2"))) static void
+	distancesSquared(Position const& pos, float const* x, float const* y,
+	                 unsigned n, float* out)
+	{
+		__m128 px = _mm_set1_ps(pos.x), py = _mm_set1_ps(pos.y);
+
+		unsigned i = 0;
+		for (; i + 4 <= n; i += 4) {
+			__m128 dx = _mm_sub_ps(px, _mm_loadu_ps(x + i));
+			__m128 dy = _mm_sub_ps(py, _mm_loadu_ps(y + i));
+			_mm_storeu_ps(out + i, _mm_add_ps(_mm_mul_ps(dx, dx),
+			                                  _mm_mul_ps(dy, dy)));
+		}
+		ScalarProximity::distancesSquared(pos, x + i, y + i, n - i, out + i);
+	}
+
+	template <typename Accept>
+	__attribute__((target("sse2"))) static bool
+	anyWithinRadius(Position const& pos, float radius, float const* x,
+	                float const* y, unsigned n, Accept& accept)
+	{
+		__m128 px = _mm_set1_ps(pos.x), py = _mm_set1_ps(pos.y);
+		__m128 r2 = _mm_set1_ps(radius * radius);
+
+		unsigned i = 0;
+		for (; i + 4 <= n; i += 4) {
+			__m128 dx = _mm_sub_ps(px, _mm_loadu_ps(x + i));
+			__m128 dy = _mm_sub_ps(py, _mm_loadu_ps(y + i));
+			__m128 d2 = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+
+			// Bit k is set if person i + k is within the radius.
+			unsigned within = _mm_movemask_ps(_mm_cmple_ps(d2, r2));
+			for (; within; within &= within - 1)
+				if (accept(i + __builtin_ctz(within))) return true;
+		}
+
+		for (; i < n; ++i)
+			if (withinRadius(pos, Position{x[i], y[i], 0}, radius) &&
+			    accept(i))
+				return true;
+		return false;
+	}
+};
+
+// NOTE: Only "avx2", not "fma" - the compiler would otherwise fuse the
+// multiplications and additions, and round differently than Position.h.
+struct AvxProximity
+{
+	__attribute__((target("avx2"))) static void
+	distancesSquared(Position const& pos, float const* x, float const* y,
+	                 unsigned n, float* out)
+	{
+		__m256 px = _mm256_set1_ps(pos.x), py = _mm256_set1_ps(pos.y);
+
+		unsigned i = 0;
+		for (; i + 8 <= n; i += 8) {
+			__m256 dx = _mm256_sub_ps(px, _mm256_loadu_ps(x + i));
+			__m256 dy = _mm256_sub_ps(py, _mm256_loadu_ps(y + i));
+			_mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_mul_ps(dx, dx),
+			                                        _mm256_mul_ps(dy, dy)));
+		}
+		ScalarProximity::distancesSquared(pos, x + i, y + i, n - i, out + i);
+	}
+
+	template <typename Accept>
+	__attribute__((target("avx2"))) static bool
+	anyWithinRadius(Position const& pos, float radius, float const* x,
+	                float const* y, unsigned n, Accept& accept)
+	{
+		__m256 px = _mm256_set1_ps(pos.x), py = _mm256_set1_ps(pos.y);
+		__m256 r2 = _mm256_set1_ps(radius * radius);
+
+		unsigned i = 0;
+		for (; i + 8 <= n; i += 8) {
+			__m256 dx = _mm256_sub_ps(px, _mm256_loadu_ps(x + i));
+			__m256 dy = _mm256_sub_ps(py, _mm256_loadu_ps(y + i));
+			__m256 d2 =
+			    _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+
+			// Bit k is set if person i + k is within the radius.
+			unsigned within =
+			    _mm256_movemask_ps(_mm256_cmp_ps(d2, r2, _CMP_LE_OQ));
+			for (; within; within &= within - 1)
+				if (accept(i + __builtin_ctz(within))) return true;
+		}
+
+		for (; i < n; ++i)
+			if (withinRadius(pos, Position{x[i], y[i], 0}, radius) &&
+			    accept(i))
+				return true;
+		return false;
+	}
+};
+
+#endif
+
+inline void distancesSquared(Position const& pos, float const* x,
+                             float const* y, unsigned n, float* out,
+                             SimdLevel level = detectSimdLevel())
+{
+#ifdef X86_SIMD
+	if (level == SimdLevel::AVX2)
+		return AvxProximity::distancesSquared(pos, x, y, n, out);
+	if (level == SimdLevel::SSE)
+		return SseProximity::distancesSquared(pos, x, y, n, out);
+#endif
+	ScalarProximity::distancesSquared(pos, x, y, n, out);
+}
+
+template <typename Accept>
+bool anyWithinRadius(Position const& pos, float radius, float const* x,
+                     float const* y, unsigned n, Accept accept,
+                     SimdLevel level = detectSimdLevel())
+{
+#ifdef X86_SIMD
+	if (level == SimdLevel::AVX2)
+		return AvxProximity::anyWithinRadius(pos, radius, x, y, n, accept);
+	if (level == SimdLevel::SSE)
+		return SseProximity::anyWithinRadius(pos, radius, x, y, n, accept);
+#endif
+	return ScalarProximity::anyWithinRadius(pos, radius, x, y, n, accept);
+}
+
+/*
+ * The people of a city as a "structure of arrays": one array per field,
+ * instead of one array of Person. A scan over the positions then reads
+ * only x and y - 8 bytes per person, densely packed - instead of dragging
+ * every whole Person (City&, location, health state: 40 bytes) through the
+ * cache, and the positions are laid out as the SIMD kernels above want
+ * them.
+ *
+ *     Population population;
+ *     population.push(loc, health);
+ *     population[i].loc.goHome();          // like Person::loc
+ *     population[i].healthState.infect(0); // like Person::healthState
+ *     population.hasSickPeopleAround(pos, 10);
+ *
+ * population[i] is a PersonRef: a proxy with the methods of PersonLocation
+ * and HealthState, which reads and writes the arrays. It refers to the
+ * person by index, so unlike a Person& it stays valid across push().
+ *
+ * NOTE: x, y and angle of someone at home are kept but meaningless, as in
+ * PersonLocation; getPosition() throws for them. PersonLocation::timeHome
+ * is not kept, as nothing ever reads it.
+ */
+class Population
+{
+	DynamicArray<float> x, y, angle;
+	DynamicArray<unsigned char> isHome; // bool
+
+	DynamicArray<unsigned> infectedAt, nextChange;
+	DynamicArray<unsigned char> hasSymptoms; // bool
+	DynamicArray<unsigned char> health;      // HealthState::healthState
+
+	using HealthKind = decltype(HealthState::healthState);
+
+public:
+	class LocationRef
+	{
+		Population& population;
+		unsigned i;
+
+	public:
+		LocationRef(Population& population, unsigned i)
+		    : population{population}, i{i}
+		{
+		}
+
+		void goHome() { population.isHome[i] = true; }
+
+		void move(float distance)
+		{
+			if (population.isHome[i])
+				throw std::runtime_error("Can't move if isHome");
+
+			Position pos = getPosition();
+			pos.move(distance);
+			population.x[i] = pos.x;
+			population.y[i] = pos.y;
+		}
+
+		Position getPosition() const
+		{
+			if (population.isHome[i])
+				throw std::runtime_error(
+				    "Can't get position of person who is home");
+			return {population.x[i], population.y[i], population.angle[i]};
+		}
+
+		bool checkIfHome() const { return population.isHome[i]; }
+
+		void goOut(Position const& loc)
+		{
+			population.isHome[i] = false;
+			population.x[i] = loc.x;
+			population.y[i] = loc.y;
+			population.angle[i] = loc.angle;
+		}
+	};
+
+	class HealthRef
+	{
+		Population& population;
+		unsigned i;
+
+	public:
+		HealthRef(Population& population, unsigned i)
+		    : population{population}, i{i}
+		{
+		}
+
+		// A copy of the health state, e.g. to put back into a Person.
+		operator HealthState() const
+		{
+			return {population.infectedAt[i], bool(population.hasSymptoms[i]),
+			        HealthKind(population.health[i]), population.nextChange[i]};
+		}
+
+		HealthRef& operator=(HealthState const& state)
+		{
+			population.infectedAt[i] = state.infectedAt;
+			population.hasSymptoms[i] = state.hasSympoms;
+			population.health[i] = state.healthState;
+			population.nextChange[i] = state.nextChange;
+			return *this;
+		}
+
+		bool isHealthy() const
+		{
+			return population.health[i] == HealthState::HEALTHY;
+		}
+
+		// NOTE: The transitions are HealthState's, on a copy.
+		void infect(unsigned now)
+		{
+			HealthState state = *this;
+			state.infect(now);
+			*this = state;
+		}
+
+		void advance()
+		{
+			HealthState state = *this;
+			state.advance();
+			*this = state;
+		}
+
+		unsigned getInfectedAt() const { return population.infectedAt[i]; }
+		bool hasSympoms() const { return population.hasSymptoms[i]; }
+	};
+
+	struct PersonRef
+	{
+		LocationRef loc;
+		HealthRef healthState;
+	};
+
+	unsigned getSize() const { return x.getSize(); }
+
+	void reserve(unsigned n)
+	{
+		x.reserve(n), y.reserve(n), angle.reserve(n), isHome.reserve(n);
+		infectedAt.reserve(n), nextChange.reserve(n);
+		hasSymptoms.reserve(n), health.reserve(n);
+	}
+
+	// Adds a person; returns their index.
+	unsigned push(PersonLocation loc, HealthState const& healthState)
+	{
+		Position pos{};
+		if (!loc.checkIfHome()) pos = loc.getPosition();
+
+		x.push(pos.x), y.push(pos.y), angle.push(pos.angle);
+		isHome.push(loc.checkIfHome());
+
+		infectedAt.push(healthState.infectedAt);
+		hasSymptoms.push(healthState.hasSympoms);
+		health.push(healthState.healthState);
+		nextChange.push(healthState.nextChange);
+		return getSize() - 1;
+	}
+
+	PersonRef operator[](unsigned i) { return {{*this, i}, {*this, i}}; }
+
+	/*
+	 * Whether anyone outside and ill is within `radius` of `pos` - the
+	 * same answer as a scan over City::people. Still O(people), but only x
+	 * and y are read, 4 or 8 people per instruction; the other fields only
+	 * for the people within the radius.
+	 */
+	bool hasSickPeopleAround(Position const& pos, float radius,
+	                         SimdLevel level = detectSimdLevel()) const
+	{
+		if (getSize() == 0) return false;
+
+		return anyWithinRadius(
+		    pos, radius, &x[0], &y[0], getSize(),
+		    [this](unsigned i) {
+			    return !isHome[i] && health[i] == HealthState::ILL;
+		    },
+		    level);
+	}
+
+	// The coordinates of everyone, for the kernels above. Valid until the
+	// next push().
+	float const* getXs() const { return getSize() ? &x[0] : nullptr; }
+	float const* getYs() const { return getSize() ? &y[0] : nullptr; }
+};
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <cstdint>
+
+/*
+ * The random numbers of the simulation. All of them come from one master
+ * seed (City::seed), so any run can be replayed exactly, and none of them
+ * from a shared generator like rand() - which every thread would have to
+ * take turns at (glibc guards it with a lock).
+ *
+ * Two generators, for two ways of splitting up the work:
+ *
+ *  - RandomStream: "counter-based" - draw k of a stream is a hash of the
+ *    stream's key and k. A stream costs nothing to make, so every person
+ *    gets a new one every tick (see City::update()), and the numbers don't
+ *    depend on which thread draws them.
+ *  - Xoshiro256: xoshiro256++, a classic generator with 256 bits of state.
+ *    A little faster per number, for long sequential runs - e.g. one per
+ *    thread, each made with Xoshiro256::stream(seed, thread).
+ *
+ * Both are UniformRandomBitGenerators, so they also work with <random>.
+ * uniform() and bernoulli() below are the fast ways to use them:
+ *
+ *     RandomStream random{seed, stream};
+ *     if (bernoulli(random, 0.3f)) ... // true 30% of the time
+ *     float angle = uniform(random) * 2 * PI;
+ *
+ * NOTE: Not for cryptography.
+ */
+
+// The SplitMix64 finalizer: scatters the bits of z over the whole result.
+inline std::uint64_t mixBits(std::uint64_t z)
+{
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+	return z ^ (z >> 31);
+}
+
+class RandomStream
+{
+	std::uint64_t key;
+	std::uint64_t counter = 0;
+
+public:
+	using result_type = std::uint64_t;
+
+	// Different (seed, stream) pairs give unrelated sequences.
+	RandomStream(std::uint64_t seed, std::uint64_t stream)
+	    : key{mixBits(seed + mixBits(stream))}
+	{
+	}
+
+	static constexpr result_type min() { return 0; }
+	static constexpr result_type max() { return UINT64_MAX; }
+
+	result_type operator()()
+	{
+		return mixBits(key + ++counter * 0x9e3779b97f4a7c15ull);
+	}
+};
+
+class Xoshiro256
+{
+	std::uint64_t s[4];
+
+	static std::uint64_t rotl(std::uint64_t x, int k)
+	{
+		return (x << k) | (x >> (64 - k));
+	}
+
+public:
+	using result_type = std::uint64_t;
+
+	// The state is filled by SplitMix64, so that it is never all zeros and
+	// similar seeds give unrelated sequences.
+	explicit Xoshiro256(std::uint64_t seed)
+	{
+		for (auto& word : s)
+			word = mixBits(seed += 0x9e3779b97f4a7c15ull);
+	}
+
+	/*
+	 * Stream `k` of `seed`: the sequence of Xoshiro256{seed}, 2^128 numbers
+	 * ahead per k. So streams 0, 1, 2 ... - e.g. one per thread - never
+	 * overlap. O(k).
+	 */
+	static Xoshiro256 stream(std::uint64_t seed, unsigned k)
+	{
+		Xoshiro256 rng{seed};
+		for (unsigned i = 0; i < k; ++i)
+			rng.jump();
+		return rng;
+	}
+
+	static constexpr result_type min() { return 0; }
+	static constexpr result_type max() { return UINT64_MAX; }
+
+	result_type operator()()
+	{
+		std::uint64_t result = rotl(s[0] + s[3], 23) + s[0];
+		std::uint64_t t = s[1] << 17;
+
+		s[2] ^= s[0];
+		s[3] ^= s[1];
+		s[1] ^= s[2];
+		s[0] ^= s[3];
+		s[2] ^= t;
+		s[3] = rotl(s[3], 45);
+		return result;
+	}
+
+	// Skips 2^128 numbers, as if operator() had been called that often.
+	void jump()
+	{
+		static const std::uint64_t JUMP[] = {
+		    0x180ec6d33cfd0abaull, 0xd5a61266f0c9392cull,
+		    0xa9582618e03fc9aaull, 0x39abdc4529b1661cull};
+
+		std::uint64_t t[4] = {};
+		for (std::uint64_t bits : JUMP) {
+			for (int b = 0; b < 64; ++b) {
+				if (bits & (1ull << b))
+					for (int w = 0; w < 4; ++w)
+						t[w] ^= s[w];
+				(*this)();
+			}
+		}
+		for (int w = 0; w < 4; ++w)
+			s[w] = t[w];
+	}
+};
+
+// Uniform in [0, 1): the top 24 bits, i.e. every float of the form k / 2^24.
+template <typename Rng> float uniform(Rng& rng)
+{
+	return float(rng() >> 40) * (1.0f / 16777216);
+}
+
+// True with probability `p` (for p in [0, 1]).
+template <typename Rng> bool bernoulli(Rng& rng, float p)
+{
+	return uniform(rng) < p;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#if defined(__x86_64__) || defined(__i386__)
+#define X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+/*
+ * The SIMD instruction sets the hand-written kernels (MatrixMultiply.h,
+ * Population.h) are written for. The binaries are built for the baseline
+ * CPU; a kernel enables its instruction set with
+ * __attribute__((target(...))) and is only called if detectSimdLevel()
+ * says the CPU has it.
+ */
+enum class SimdLevel { SCALAR, SSE, AVX2 };
+
+// The best instruction set the current CPU supports. Checked once.
+// NOTE: AVX2 implies FMA - every CPU with AVX2 so far has it.
+inline SimdLevel detectSimdLevel()
+{
+#ifdef X86_SIMD
+	static const SimdLevel level =
+	    __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")
+	        ? SimdLevel::AVX2
+	        : __builtin_cpu_supports("sse2") ? SimdLevel::SSE
+	                                         : SimdLevel::SCALAR;
+	return level;
+#else
+	return SimdLevel::SCALAR;
+#endif
+}
@@ -0,0 +1,308 @@
+#pragma once
+
+#include "AllocationTrace.h"
+#include "Elements.h"
+#include <cstdlib>
+#include <new>
+#include <utility>
+
+/*
+ * A DynamicArray which keeps its first N elements *inside* the object itself,
+ * instead of on the heap. As long as there are at most N elements, it never
+ * calls malloc(). Only when it grows beyond N, the elements "spill" to a heap
+ * block, and from then on it behaves just like DynamicArray.
+ *
+ * Good for many short arrays, e.g. a person's handful of contacts:
+ *     SmallDynamicArray<Person*, 8> contacts;
+ *
+ * NOTE: The price is a bigger object - sizeof() includes room for N elements,
+ * whether they are used or not. Moving it may also have to move the elements
+ * one by one, as they can't be "stolen" when they live inside the object.
+ */
+template <typename T, unsigned N> struct SmallDynamicArray
+{
+	static_assert(N > 0, "Use DynamicArray<T> when there is no inline room");
+
+private:
+	using Ops = Elements<T>;
+
+	// Points either to `inlineStorage` or to a heap block.
+	T* array;
+	unsigned size;
+	unsigned allocated;
+
+	// Raw, suitably aligned memory for N elements.
+	alignas(T) unsigned char inlineStorage[N * sizeof(T)];
+
+	T* inlineArray() { return reinterpret_cast<T*>(inlineStorage); }
+
+	bool isInline() const
+	{
+		return array == reinterpret_cast<T const*>(inlineStorage);
+	}
+
+	static T* allocate(unsigned n)
+	{
+		void* memory = std::malloc(n * sizeof(T));
+		if (!memory) throw std::bad_alloc();
+		traceAllocate<SmallDynamicArray>(memory, n * sizeof(T));
+		return static_cast<T*>(memory);
+	}
+
+	static void deallocate(T* p, unsigned n)
+	{
+		traceDeallocate<SmallDynamicArray>(p, n * sizeof(T));
+		std::free(p);
+	}
+
+	// Releases the heap block, if any, and goes back to the inline storage.
+	// The elements must already be destroyed (or moved out).
+	void releaseHeap()
+	{
+		if (!isInline()) deallocate(array, allocated);
+		array = inlineArray();
+		allocated = N;
+	}
+
+	/*
+	 * Moves the elements to `resized` (raw memory for `newCapacity`
+	 * elements - on the heap or the inline storage) and releases the old
+	 * block. If moving throws, the array is left untouched.
+	 */
+	void moveInto(T* resized, unsigned newCapacity)
+	{
+		Ops::moveInto(resized, array, size);
+		Ops::destroy(array, array + size);
+
+		if (!isInline()) deallocate(array, allocated);
+		array = resized;
+		allocated = newCapacity;
+	}
+
+	// Moves the elements to a heap block for exactly `newCapacity` elements.
+	void reallocate(unsigned newCapacity)
+	{
+		T* resized = allocate(newCapacity);
+		try {
+			moveInto(resized, newCapacity);
+		} catch (...) {
+			deallocate(resized, newCapacity);
+			throw;
+		}
+	}
+
+	void clear()
+	{
+		Ops::destroy(array, array + size);
+		size = 0;
+	}
+
+	// Takes over the elements of `other`, which must be empty afterwards.
+	void takeFrom(SmallDynamicArray& other)
+	{
+		if (other.isInline()) {
+			// The elements live inside `other`; we can't steal them.
+			Ops::moveInto(array, other.array, other.size);
+			Ops::destroy(other.array, other.array + other.size);
+			size = other.size;
+		} else {
+			array = other.array;
+			size = other.size;
+			allocated = other.allocated;
+			other.array = other.inlineArray();
+			other.allocated = N;
+		}
+		other.size = 0;
+	}
+
+public:
+	SmallDynamicArray() : array{inlineArray()}, size{0}, allocated{N} {}
+
+	// Creates `n` value-initialized elements (T{}).
+	SmallDynamicArray(unsigned n) : SmallDynamicArray()
+	{
+		reserve(n);
+		for (; size < n; ++size)
+			new (array + size) T();
+	}
+
+	SmallDynamicArray(SmallDynamicArray const& other) : SmallDynamicArray()
+	{
+		extendWith(other);
+	}
+
+	// NOTE: noexcept only if moving the inline elements can't throw.
+	SmallDynamicArray(SmallDynamicArray&& other) noexcept(
+	    std::is_nothrow_move_constructible<T>::value)
+	    : SmallDynamicArray()
+	{
+		takeFrom(other);
+	}
+
+	SmallDynamicArray& operator=(SmallDynamicArray const& other)
+	{
+		if (this != &other) {
+			clear();
+			extendWith(other);
+		}
+		return *this;
+	}
+
+	SmallDynamicArray& operator=(SmallDynamicArray&& other) noexcept(
+	    std::is_nothrow_move_constructible<T>::value)
+	{
+		if (this != &other) {
+			clear();
+			releaseHeap();
+			takeFrom(other);
+		}
+		return *this;
+	}
+
+	unsigned getSize() const { return size; }
+
+	// Number of elements the array can hold before it has to reallocate.
+	unsigned capacity() const { return allocated; }
+
+	T& operator[](unsigned i) { return array[i]; }
+	T const& operator[](unsigned i) const { return array[i]; }
+
+	// Makes room for at least `n` elements. Never shrinks.
+	void reserve(unsigned n)
+	{
+		if (n > allocated) reallocate(n);
+	}
+
+	/*
+	 * Releases the spare capacity. If the elements fit in the inline
+	 * storage again, the heap block is released entirely.
+	 */
+	void shrink_to_fit()
+	{
+		if (isInline() || allocated == size) return;
+
+		if (size <= N)
+			moveInto(inlineArray(), N);
+		else
+			reallocate(size);
+	}
+
+	/*
+	 * Constructs a new element at the end of the array from `args`.
+	 * When the spare room runs out, the capacity is doubled.
+	 */
+	template <typename... Args> T& emplace(Args&&... args)
+	{
+		if (size < allocated) {
+			new (array + size) T(std::forward<Args>(args)...);
+		} else {
+			// NOTE: `args` may refer to an element of this very array, so we
+			// construct the new element before the old memory is released.
+			unsigned newCapacity = allocated * 2;
+			T* resized = allocate(newCapacity);
+			try {
+				new (resized + size) T(std::forward<Args>(args)...);
+			} catch (...) {
+				deallocate(resized, newCapacity);
+				throw;
+			}
+
+			try {
+				moveInto(resized, newCapacity);
+			} catch (...) {
+				resized[size].~T();
+				deallocate(resized, newCapacity);
+				throw;
+			}
+		}
+
+		return array[size++];
+	}
+
+	void push(const T& newElement) { emplace(newElement); }
+
+	void push(T&& newElement) { emplace(std::move(newElement)); }
+
+	/*
+	 * Appends copies of all elements of `other` at the end of this array.
+	 * Reallocates at most once.
+	 */
+	void extendWith(SmallDynamicArray const& other)
+	{
+		unsigned count = other.size;
+		if (size + count > allocated) {
+			unsigned newCapacity = allocated * 2;
+			if (newCapacity < size + count) newCapacity = size + count;
+
+			// NOTE: `other` may be this very array.
+			if (&other == this) {
+				SmallDynamicArray copy{other};
+				reserve(newCapacity);
+				extendWith(copy);
+				return;
+			}
+			reserve(newCapacity);
+		}
+
+		Ops::copyInto(array + size, other.array, count);
+		size += count;
+	}
+
+	// Removes the n'th element, keeping the order of the rest.
+	void deleteAt(unsigned n)
+	{
+		Ops::shiftLeft(array + n, array + n + 1, size - n - 1);
+
+		size--;
+		array[size].~T();
+	}
+
+	// Removes the elements with indices [start, start + length).
+	void deleteRange(unsigned start, unsigned length)
+	{
+		if (start >= size) return;
+		if (length > size - start) length = size - start;
+
+		unsigned tail = start + length;
+		Ops::shiftLeft(array + start, array + tail, size - tail);
+
+		Ops::destroy(array + size - length, array + size);
+		size -= length;
+	}
+
+	// Removes the n'th element in O(1), moving the last element in its place.
+	void deleteAtUnordered(unsigned n)
+	{
+		if (n != size - 1) Ops::relocate(array + n, array + size - 1);
+
+		size--;
+		array[size].~T();
+	}
+
+	/*
+	 * Removes every element for which `pred(element)` is true, keeping the
+	 * order of the rest, in a single pass. Returns the number of removed
+	 * elements.
+	 */
+	template <typename Predicate> unsigned eraseIf(Predicate pred)
+	{
+		unsigned kept = 0;
+		for (unsigned i = 0; i < size; ++i) {
+			if (pred(array[i])) continue;
+
+			if (kept != i) Ops::relocate(array + kept, array + i);
+			kept++;
+		}
+
+		unsigned removed = size - kept;
+		Ops::destroy(array + kept, array + size);
+		size = kept;
+		return removed;
+	}
+
+	~SmallDynamicArray()
+	{
+		Ops::destroy(array, array + size);
+		if (!isInline()) deallocate(array, allocated);
+	}
+};
@@ -0,0 +1,402 @@
+#pragma once
+
+#include "BoundedQueue.h"
+#include "City.h"
+#include "DynamicArray.h"
+#include "Person.h"
+#include "Position.h"
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+/*
+ * Streams the state of a City to a file, tick after tick, for a viewer to
+ * show "in real time" (or to replay later):
+ *
+ *     SnapshotWriter writer{"city.snap"};
+ *     while (...) {
+ *         city.update(1);
+ *         writer.write(city); // only encodes - the I/O is done elsewhere
+ *     }
+ *     writer.close();
+ *     ...
+ *     SnapshotReader reader{"city.snap"};
+ *     while (reader.next())
+ *         draw(reader.getPosition(i), reader.getHealth(i), ...);
+ *
+ * Each frame holds only what changed since the frame before it: the
+ * people whose position or status (health, symptoms, at home) is
+ * different. write() encodes the frame and hands it to a background thread
+ * through a BoundedQueue, so the simulation never waits for the disk.
+ *
+ * NOTE: If the disk can't keep up and the queue is full, the frame is
+ * dropped - and the next one holds the changes of both, as a frame is
+ * always relative to the last frame *sent*. So the stream stays exact; a
+ * viewer only sees fewer frames. To send about 10 frames per second, call
+ * write() only on every k-th tick.
+ *
+ * Stream layout (numbers as "varints": 7 bits per byte, lowest first, the
+ * top bit set on every byte but the last; floats as their 4 bytes, native
+ * byte order - as in MappedFile.h):
+ *
+ *     SnapshotHeader                  16 bytes
+ *     frames, each:
+ *         tick, time, people, changes varints
+ *         changes x:
+ *             gap                     varint - the index of the person,
+ *                                     minus (the previous one's + 1)
+ *             status                  1 byte, see Snapshot::statusOf()
+ *             x, y                    floats, if status has POSITION
+ *
+ * A person who went home has no position, so it isn't sent. A frame may
+ * have fewer people than the one before (e.g. travelers left, see World):
+ * the last ones are gone. The first frame sends everybody.
+ */
+
+struct SnapshotHeader
+{
+	static constexpr char MAGIC[8] = {'D', 'Y', 'N', 'A', 'S', 'N', 'A', 'P'};
+	static constexpr uint32_t VERSION = 1;
+
+	char magic[8];
+	uint32_t version;
+	uint32_t reserved; // Zero.
+};
+
+static_assert(sizeof(SnapshotHeader) == 16, "The header is part of the format");
+
+namespace Snapshot
+{
+// The bits of the status byte.
+enum : unsigned char {
+	HEALTH = 0x03,   // HealthState::healthState
+	SYMPTOMS = 0x04, // HealthState::hasSympoms
+	HOME = 0x08,     // PersonLocation::checkIfHome()
+	POSITION = 0x10, // x and y follow. Only in the stream.
+};
+
+inline unsigned char statusOf(Person& person)
+{
+	return (person.healthState.healthState & HEALTH) |
+	       (person.healthState.hasSympoms ? SYMPTOMS : 0) |
+	       (person.loc.checkIfHome() ? HOME : 0);
+}
+
+inline void putVarint(DynamicArray<unsigned char>& out, uint64_t value)
+{
+	for (; value >= 0x80; value >>= 7)
+		out.push((unsigned char)(value | 0x80));
+	out.push((unsigned char)value);
+}
+
+inline void putFloat(DynamicArray<unsigned char>& out, float value)
+{
+	unsigned char bytes[sizeof(float)];
+	std::memcpy(bytes, &value, sizeof(float));
+	for (unsigned char byte : bytes)
+		out.push(byte);
+}
+} // namespace Snapshot
+
+class SnapshotWriter
+{
+	using Frame = DynamicArray<unsigned char>;
+
+	std::FILE* file;
+	BoundedQueue<Frame> frames; // To the I/O thread.
+	BoundedQueue<Frame> spare;  // Back from it, to be reused.
+	std::thread io;
+	std::atomic<bool> failed{false};
+
+	// Everybody as of the last frame sent.
+	DynamicArray<float> x, y;
+	DynamicArray<unsigned char> status;
+
+	DynamicArray<unsigned> changed; // The people in the frame being made.
+	unsigned dropped = 0;
+
+	void writeFrames()
+	{
+		Frame frame;
+		while (frames.pop(frame)) {
+			if (std::fwrite(&frame[0], 1, frame.getSize(), file) !=
+			    frame.getSize())
+				failed = true;
+
+			frame.deleteRange(0, frame.getSize());
+			spare.tryPush(std::move(frame));
+		}
+	}
+
+public:
+	/*
+	 * Creates (or overwrites) the file at `path`. Up to `capacity` frames
+	 * may wait for the disk before write() starts dropping them.
+	 */
+	explicit SnapshotWriter(const char* path, unsigned capacity = 16)
+	    : frames{capacity}, spare{capacity}
+	{
+		file = std::fopen(path, "wb");
+		if (!file)
+			throw std::runtime_error(std::string("Can't create ") + path);
+
+		SnapshotHeader header{};
+		std::memcpy(header.magic, SnapshotHeader::MAGIC,
+		            sizeof(SnapshotHeader::MAGIC));
+		header.version = SnapshotHeader::VERSION;
+		if (std::fwrite(&header, sizeof(header), 1, file) != 1) {
+			std::fclose(file);
+			throw std::runtime_error(std::string("Can't write ") + path);
+		}
+
+		io = std::thread{[this] { writeFrames(); }};
+	}
+
+	SnapshotWriter(SnapshotWriter const&) = delete;
+	SnapshotWriter& operator=(SnapshotWriter const&) = delete;
+
+	// NOTE: Doesn't report errors - call close() to know if all went well.
+	~SnapshotWriter()
+	{
+		if (file) {
+			frames.close();
+			io.join();
+			std::fclose(file);
+		}
+	}
+
+	/*
+	 * Writes the frames still waiting and closes the file. Throws if any
+	 * frame couldn't be written.
+	 */
+	void close()
+	{
+		if (!file) return;
+
+		frames.close();
+		io.join();
+		bool ok = std::fclose(file) == 0 && !failed;
+		file = nullptr;
+		if (!ok) throw std::runtime_error("Can't write the snapshots");
+	}
+
+	// The number of frames dropped because the disk was behind.
+	unsigned getDropped() const { return dropped; }
+
+	/*
+	 * Encodes the changes since the last frame sent, and queues them.
+	 * Returns false if the queue was full and the frame was dropped (its
+	 * changes go with the next frame). O(people) - never waits for I/O.
+	 */
+	bool write(City& city)
+	{
+		using namespace Snapshot;
+
+		DynamicArray<Person>& people = city.people;
+		unsigned size = people.getSize();
+		unsigned known = x.getSize() < size ? x.getSize() : size;
+
+		changed.deleteRange(0, changed.getSize());
+		for (unsigned i = 0; i < size; ++i) {
+			unsigned char now = statusOf(people[i]);
+			if (i >= known || now != status[i]) {
+				changed.push(i);
+			} else if (!(now & HOME)) {
+				Position pos = people[i].loc.getPosition();
+				if (pos.x != x[i] || pos.y != y[i]) changed.push(i);
+			}
+		}
+
+		Frame frame;
+		spare.tryPop(frame);
+		putVarint(frame, city.tick);
+		putVarint(frame, city.time);
+		putVarint(frame, size);
+		putVarint(frame, changed.getSize());
+
+		unsigned next = 0; // The index after the previous change.
+		for (unsigned k = 0; k < changed.getSize(); ++k) {
+			unsigned i = changed[k];
+			unsigned char now = statusOf(people[i]);
+
+			putVarint(frame, i - next);
+			next = i + 1;
+			if (now & HOME) {
+				frame.push(now);
+			} else {
+				Position pos = people[i].loc.getPosition();
+				frame.push(now | POSITION);
+				putFloat(frame, pos.x);
+				putFloat(frame, pos.y);
+			}
+		}
+
+		if (!frames.tryPush(std::move(frame))) {
+			dropped++;
+			return false;
+		}
+
+		// Sent: this is what the next frame is relative to.
+		while (x.getSize() < size)
+			x.push(0), y.push(0), status.push(0);
+		x.deleteRange(size, x.getSize() - size);
+		y.deleteRange(size, y.getSize() - size);
+		status.deleteRange(size, status.getSize() - size);
+
+		for (unsigned k = 0; k < changed.getSize(); ++k) {
+			unsigned i = changed[k];
+			status[i] = statusOf(people[i]);
+			if (!(status[i] & HOME)) {
+				Position pos = people[i].loc.getPosition();
+				x[i] = pos.x;
+				y[i] = pos.y;
+			}
+		}
+		return true;
+	}
+};
+
+/*
+ * Replays a stream of SnapshotWriter: next() applies the next frame, and
+ * the getters tell the state of everybody after it.
+ */
+class SnapshotReader
+{
+	std::FILE* file;
+	std::string path;
+
+	uint64_t tick = 0, time = 0;
+	DynamicArray<float> x, y;
+	DynamicArray<unsigned char> status;
+
+	[[noreturn]] void corrupt() const
+	{
+		throw std::runtime_error("Broken snapshot stream in " + path);
+	}
+
+	// Returns false at the end of the file, if `atEnd` is allowed there.
+	bool getVarint(uint64_t& value, bool atEnd = false)
+	{
+		value = 0;
+		for (unsigned shift = 0; shift < 64; shift += 7) {
+			int byte = std::fgetc(file);
+			if (byte == EOF) {
+				if (atEnd && shift == 0) return false;
+				corrupt();
+			}
+			value |= uint64_t(byte & 0x7f) << shift;
+			if (!(byte & 0x80)) return true;
+		}
+		corrupt();
+	}
+
+	unsigned char getByte()
+	{
+		int byte = std::fgetc(file);
+		if (byte == EOF) corrupt();
+		return (unsigned char)byte;
+	}
+
+	float getFloat()
+	{
+		unsigned char bytes[sizeof(float)];
+		for (unsigned char& byte : bytes)
+			byte = getByte();
+
+		float value;
+		std::memcpy(&value, bytes, sizeof(float));
+		return value;
+	}
+
+public:
+	explicit SnapshotReader(const char* path) : path{path}
+	{
+		file = std::fopen(path, "rb");
+		if (!file)
+			throw std::runtime_error(std::string("Can't open ") + path);
+
+		SnapshotHeader header;
+		if (std::fread(&header, sizeof(header), 1, file) != 1 ||
+		    std::memcmp(header.magic, SnapshotHeader::MAGIC,
+		                sizeof(SnapshotHeader::MAGIC)) != 0 ||
+		    header.version != SnapshotHeader::VERSION) {
+			std::fclose(file);
+			throw std::runtime_error(std::string("Not a snapshot stream: ") +
+			                         path);
+		}
+	}
+
+	SnapshotReader(SnapshotReader const&) = delete;
+	SnapshotReader& operator=(SnapshotReader const&) = delete;
+
+	~SnapshotReader() { std::fclose(file); }
+
+	/*
+	 * Applies the next frame. Returns false at the end of the stream; throws
+	 * if the stream is broken (e.g. cut off in the middle of a frame).
+	 */
+	bool next()
+	{
+		using namespace Snapshot;
+
+		uint64_t frameTick, size, changes;
+		if (!getVarint(frameTick, true)) return false;
+		tick = frameTick;
+		getVarint(time);
+		getVarint(size);
+		getVarint(changes);
+		if (size > UINT32_MAX || changes > size) corrupt();
+
+		while (x.getSize() < size)
+			x.push(0), y.push(0), status.push(HOME);
+		x.deleteRange(size, x.getSize() - size);
+		y.deleteRange(size, y.getSize() - size);
+		status.deleteRange(size, status.getSize() - size);
+
+		uint64_t i = 0;
+		for (uint64_t k = 0; k < changes; ++k, ++i) {
+			uint64_t gap;
+			getVarint(gap);
+			i += gap;
+			if (i >= size) corrupt();
+
+			unsigned char now = getByte();
+			if (now & POSITION) {
+				x[i] = getFloat();
+				y[i] = getFloat();
+			}
+			status[i] = now & ~POSITION;
+		}
+		return true;
+	}
+
+	uint64_t getTick() const { return tick; }
+	uint64_t getTime() const { return time; }
+	unsigned getSize() const { return x.getSize(); }
+
+	bool checkIfHome(unsigned i) const { return status[i] & Snapshot::HOME; }
+
+	decltype(HealthState::healthState) getHealth(unsigned i) const
+	{
+		return decltype(HealthState::healthState)(status[i] &
+		                                          Snapshot::HEALTH);
+	}
+
+	bool hasSympoms(unsigned i) const
+	{
+		return status[i] & Snapshot::SYMPTOMS;
+	}
+
+	// NOTE: Only x and y - the direction isn't sent.
+	Position getPosition(unsigned i) const
+	{
+		if (checkIfHome(i))
+			throw std::runtime_error(
+			    "Can't get position of person who is home");
+		return {x[i], y[i], 0};
+	}
+};
@@ -0,0 +1,222 @@
+#pragma once
+
+#include "DynamicArray.h"
+#include "Matrix.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <stdexcept>
+
+/*
+ * Sparse matrices keep only the non-zero elements, so a 1M x 1M matrix with
+ * a few million non-zeros takes megabytes instead of terabytes.
+ *
+ * They are built in two steps:
+ *  1. SparseMatrixBuilder collects (row, col, value) triplets in any order -
+ *     the "coordinate" (COO) format. Cheap to add to, slow to use.
+ *  2. build() sorts them into a SparseMatrix in "compressed sparse row"
+ *     (CSR) format: the non-zeros row after row, with their columns, and
+ *     where each row starts. Compact and fast to multiply with.
+ *
+ *     SparseMatrixBuilder<float> contacts{districts, districts};
+ *     contacts.add(3, 7, 0.25f);
+ *     SparseMatrix<float> rates = contacts.build();
+ */
+template <typename T> class SparseMatrix
+{
+	unsigned rows, cols;
+
+	// The non-zeros of row i are at positions [rowStart[i], rowStart[i + 1])
+	// of `values`, sorted by column; `colIndex` holds their columns.
+	DynamicArray<unsigned> rowStart; // rows + 1 elements
+	DynamicArray<unsigned> colIndex; // one per non-zero
+	DynamicArray<T> values;          // one per non-zero
+
+	template <typename> friend class SparseMatrixBuilder;
+
+	// y[i] = row i * x, for the rows in [begin, end).
+	void multiplyRows(T const* x, T* y, unsigned begin, unsigned end) const
+	{
+		for (unsigned i = begin; i < end; ++i) {
+			T sum{};
+			for (unsigned k = rowStart[i]; k < rowStart[i + 1]; ++k)
+				sum += values[k] * x[colIndex[k]];
+			y[i] = sum;
+		}
+	}
+
+public:
+	SparseMatrix(unsigned rows = 0, unsigned cols = 0)
+	    : rows{rows}, cols{cols}, rowStart(rows + 1)
+	{
+	}
+
+	// Keeps the elements of `dense` which are not T{}.
+	template <typename A>
+	static SparseMatrix fromDense(Matrix<T, A> const& dense)
+	{
+		SparseMatrix result{dense.getRows(), dense.getCols()};
+		for (unsigned i = 0; i < dense.getRows(); ++i) {
+			for (unsigned j = 0; j < dense.getCols(); ++j) {
+				if (dense.get(i, j) == T{}) continue;
+
+				result.colIndex.push(j);
+				result.values.push(dense.get(i, j));
+			}
+			result.rowStart[i + 1] = result.values.getSize();
+		}
+		return result;
+	}
+
+	Matrix<T> toDense() const
+	{
+		Matrix<T> dense{rows, cols};
+		for (unsigned i = 0; i < rows; ++i)
+			for (unsigned k = rowStart[i]; k < rowStart[i + 1]; ++k)
+				dense.set(i, colIndex[k], values[k]);
+		return dense;
+	}
+
+	unsigned getRows() const { return rows; }
+	unsigned getCols() const { return cols; }
+	unsigned getNonZeros() const { return values.getSize(); }
+
+	// The element (row, col), or T{} if it is not stored. O(log(row length)).
+	T get(unsigned row, unsigned col) const
+	{
+		if (rowStart[row] == rowStart[row + 1]) return T{};
+
+		unsigned const* first = &colIndex[0] + rowStart[row];
+		unsigned const* last = &colIndex[0] + rowStart[row + 1];
+		unsigned const* found = std::lower_bound(first, last, col);
+
+		if (found == last || *found != col) return T{};
+		return values[found - &colIndex[0]];
+	}
+
+	/*
+	 * y = this * x, where `x` has getCols() elements and `y` - getRows().
+	 * Every row is independent, so with a `pool` the rows are split in
+	 * blocks over the threads. The result is the same either way.
+	 */
+	void multiply(T const* x, T* y, ThreadPool* pool = nullptr) const
+	{
+		const unsigned BLOCK = 4096;
+		unsigned blocks = (rows + BLOCK - 1) / BLOCK;
+		auto block = [&](unsigned b) {
+			unsigned begin = b * BLOCK;
+			unsigned end = begin + BLOCK < rows ? begin + BLOCK : rows;
+			multiplyRows(x, y, begin, end);
+		};
+
+		if (pool)
+			pool->parallelFor(blocks, block);
+		else
+			for (unsigned b = 0; b < blocks; ++b)
+				block(b);
+	}
+
+	DynamicArray<T> multiply(DynamicArray<T> const& x,
+	                         ThreadPool* pool = nullptr) const
+	{
+		if (x.getSize() != cols)
+			throw std::runtime_error("The vector must have getCols() elements");
+
+		DynamicArray<T> y(rows);
+		if (rows) multiply(&x[0], &y[0], pool);
+		return y;
+	}
+
+	DynamicArray<T> multiply(DynamicArray<T> const& x, ThreadPool& pool) const
+	{
+		return multiply(x, &pool);
+	}
+};
+
+/*
+ * Collects the non-zeros of a sparse matrix in any order.
+ */
+template <typename T> class SparseMatrixBuilder
+{
+	struct Entry
+	{
+		unsigned row, col;
+		T value;
+	};
+
+	unsigned rows, cols;
+	DynamicArray<Entry> entries;
+
+public:
+	SparseMatrixBuilder(unsigned rows, unsigned cols) : rows{rows}, cols{cols}
+	{
+	}
+
+	// Use it when the number of non-zeros is known in advance.
+	void reserve(unsigned nonZeros) { entries.reserve(nonZeros); }
+
+	// NOTE: Adding the same (row, col) twice sums the values.
+	void add(unsigned row, unsigned col, T const& value)
+	{
+		if (row >= rows || col >= cols)
+			throw std::runtime_error("Sparse matrix index out of range");
+
+		entries.push(Entry{row, col, value});
+	}
+
+	/*
+	 * Sorts the entries into CSR format in O(nonZeros + rows) plus sorting
+	 * each row by column.
+	 */
+	SparseMatrix<T> build() const
+	{
+		SparseMatrix<T> result{rows, cols};
+		unsigned count = entries.getSize();
+
+		// 1. Count the entries of every row; the running sum tells where
+		// each row starts ("counting sort").
+		DynamicArray<unsigned>& start = result.rowStart;
+		for (unsigned k = 0; k < count; ++k)
+			start[entries[k].row + 1]++;
+		for (unsigned i = 0; i < rows; ++i)
+			start[i + 1] += start[i];
+
+		// 2. Put every entry in its row.
+		DynamicArray<unsigned> next = start;
+		DynamicArray<unsigned> order(count);
+		for (unsigned k = 0; k < count; ++k)
+			order[next[entries[k].row]++] = k;
+
+		// 3. Sort every row by column and merge duplicates.
+		result.colIndex.reserve(count);
+		result.values.reserve(count);
+		unsigned rowBegin = 0;
+		for (unsigned i = 0; i < rows; ++i) {
+			unsigned rowEnd = start[i + 1];
+			if (rowEnd - rowBegin > 1)
+				std::sort(&order[rowBegin], &order[0] + rowEnd,
+				          [&](unsigned a, unsigned b) {
+					          return entries[a].col < entries[b].col;
+				          });
+
+			unsigned first = result.values.getSize();
+			for (unsigned k = rowBegin; k < rowEnd; ++k) {
+				Entry const& e = entries[order[k]];
+				unsigned last = result.values.getSize();
+				if (last > first && result.colIndex[last - 1] == e.col) {
+					result.values[last - 1] += e.value;
+				} else {
+					result.colIndex.push(e.col);
+					result.values.push(e.value);
+				}
+			}
+
+			rowBegin = rowEnd;
+			start[i] = first;
+		}
+		start[rows] = result.values.getSize();
+
+		result.colIndex.shrink_to_fit();
+		result.values.shrink_to_fit();
+		return result;
+	}
+};
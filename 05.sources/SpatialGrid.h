@@ -0,0 +1,134 @@
+#pragma once
+
+#include "DynamicArray.h"
+#include "Position.h"
+#include <cmath>
+
+/*
+ * A uniform grid over the plane, for "is anyone within `radius` of here?"
+ * without checking everyone.
+ *
+ * The plane is cut into square cells of `cellSize`. A query only looks at
+ * the cells which the circle touches - with cellSize about equal to the
+ * radius, that's 9 cells or fewer - so its cost depends on how crowded the
+ * neighbourhood is, not on how many points there are in total.
+ *
+ * The plane is unbounded, so the cells are hashed into a table with about
+ * two buckets per point ("spatial hashing"). Two cells may share a bucket;
+ * that only costs a few extra distance checks.
+ *
+ * Building is two steps, like SparseMatrixBuilder:
+ *
+ *     grid.clear();
+ *     grid.add(pos);  // ... for every point
+ *     grid.build();   // O(points), sorts the points by bucket
+ *     grid.anyWithin(pos, radius);
+ *
+ * NOTE: The memory is kept between builds, so rebuilding the grid every
+ * simulation tick doesn't allocate once the population has stabilized.
+ */
+class SpatialGrid
+{
+	float cellSize;
+
+	DynamicArray<Position> added;  // Since clear(), in any order.
+	DynamicArray<Position> points; // Sorted by bucket, after build().
+
+	// The points of bucket b are points[bucketStart[b]] ... up to
+	// points[bucketStart[b + 1] - 1].
+	DynamicArray<unsigned> bucketStart;
+	unsigned bucketMask = 0; // The number of buckets - 1 (a power of two).
+
+	int cellOf(float coordinate) const
+	{
+		return int(std::floor(coordinate / cellSize));
+	}
+
+	unsigned bucketOf(int cellX, int cellY) const
+	{
+		// Multiplying by big primes scatters neighbouring cells.
+		return ((unsigned(cellX) * 73856093u) ^ (unsigned(cellY) * 19349663u)) &
+		       bucketMask;
+	}
+
+	unsigned bucketOf(Position const& pos) const
+	{
+		return bucketOf(cellOf(pos.x), cellOf(pos.y));
+	}
+
+	bool anyInBucket(unsigned bucket, Position const& pos, float radius) const
+	{
+		for (unsigned k = bucketStart[bucket]; k < bucketStart[bucket + 1]; ++k)
+			if (withinRadius(pos, points[k], radius)) return true;
+		return false;
+	}
+
+public:
+	explicit SpatialGrid(float cellSize) : cellSize{cellSize} {}
+
+	// Removes all points; the memory stays for the next build.
+	void clear() { added.deleteRange(0, added.getSize()); }
+
+	void add(Position const& pos) { added.push(pos); }
+
+	unsigned getSize() const { return points.getSize(); }
+
+	/*
+	 * Sorts the added points by bucket ("counting sort" - one pass to count,
+	 * one to place), so that each bucket is a contiguous range.
+	 */
+	void build()
+	{
+		unsigned count = added.getSize();
+		unsigned buckets = 16;
+		while (buckets < 2 * count)
+			buckets *= 2;
+		bucketMask = buckets - 1;
+
+		if (bucketStart.getSize() != buckets + 1)
+			bucketStart = DynamicArray<unsigned>(buckets + 1);
+		else
+			for (unsigned b = 0; b <= buckets; ++b)
+				bucketStart[b] = 0;
+
+		// 1. Count the points of each bucket, then sum up the counts, so
+		// that bucketStart[b] is where bucket b *ends*.
+		for (unsigned i = 0; i < count; ++i)
+			bucketStart[bucketOf(added[i])]++;
+		for (unsigned b = 1; b < buckets; ++b)
+			bucketStart[b] += bucketStart[b - 1];
+		bucketStart[buckets] = count;
+
+		// 2. Place the points, filling every bucket from its end. Afterwards
+		// bucketStart[b] is where bucket b starts.
+		// NOTE: `points` only grows, and its slots are overwritten.
+		while (points.getSize() < count)
+			points.push(Position{});
+		points.deleteRange(count, points.getSize() - count);
+
+		for (unsigned i = 0; i < count; ++i)
+			points[--bucketStart[bucketOf(added[i])]] = added[i];
+	}
+
+	// Whether any point is within `radius` of `pos` (edge included).
+	bool anyWithin(Position const& pos, float radius) const
+	{
+		if (points.getSize() == 0) return false;
+
+		int x0 = cellOf(pos.x - radius), x1 = cellOf(pos.x + radius);
+		int y0 = cellOf(pos.y - radius), y1 = cellOf(pos.y + radius);
+
+		// A huge radius touches more cells than there are buckets: just
+		// check every point.
+		if (double(x1 - x0 + 1) * (y1 - y0 + 1) > bucketMask + 1) {
+			for (unsigned k = 0; k < points.getSize(); ++k)
+				if (withinRadius(pos, points[k], radius)) return true;
+			return false;
+		}
+
+		for (int y = y0; y <= y1; ++y)
+			for (int x = x0; x <= x1; ++x)
+				if (anyInBucket(bucketOf(x, y), pos, radius)) return true;
+		return false;
+	}
+};
@@ -0,0 +1,167 @@
+#pragma once
+
+#include "DynamicArray.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+/*
+ * A fixed set of worker threads which are started once and then reused for
+ * many parallel loops - starting a thread costs tens of microseconds, far
+ * more than a small loop.
+ *
+ *     ThreadPool pool{4};
+ *     pool.parallelFor(100, [&](unsigned i) { work(i); });
+ *
+ * NOTE: The thread calling parallelFor() works too, so a pool of N workers
+ * runs on N + 1 threads. A pool with 0 workers simply runs the loop on the
+ * calling thread.
+ * parallelFor() must not be called from inside a task of the same pool, and
+ * tasks must not throw.
+ */
+class ThreadPool
+{
+	DynamicArray<std::thread> workers;
+
+	std::mutex mutex;
+	std::condition_variable wake; // A new job, or stop.
+	std::condition_variable done; // A worker finished its part of the job.
+
+	// The current job, type-erased: invoke(context, i) calls the task for i.
+	void (*invoke)(void*, unsigned) = nullptr;
+	void* context = nullptr;
+	unsigned jobSize = 0;
+	std::atomic<unsigned> nextIndex{0};
+
+	unsigned busyWorkers = 0;
+	unsigned long long generation = 0; // Incremented for every new job.
+	bool stopping = false;
+
+	// Only one parallelFor() at a time may use the workers.
+	std::mutex submitMutex;
+
+	// Takes indices until there are none left.
+	void runTasks()
+	{
+		for (unsigned i; (i = nextIndex.fetch_add(1)) < jobSize;)
+			invoke(context, i);
+	}
+
+	// `seen` is the last job this worker must not run: the one current when
+	// it started.
+	void workerLoop(unsigned long long seen)
+	{
+		while (true) {
+			{
+				std::unique_lock<std::mutex> lock{mutex};
+				wake.wait(lock, [&] { return stopping || generation != seen; });
+				if (stopping) return;
+				seen = generation;
+			}
+
+			runTasks();
+
+			std::lock_guard<std::mutex> lock{mutex};
+			if (--busyWorkers == 0) done.notify_one();
+		}
+	}
+
+	/*
+	 * NOTE: After a resize(), `generation` is no longer 0. A new worker must
+	 * start from its current value - otherwise it would take that old job
+	 * for a new one, and count itself done (busyWorkers) for a job it was
+	 * never given.
+	 */
+	void start(unsigned threads)
+	{
+		unsigned long long current;
+		{
+			std::lock_guard<std::mutex> lock{mutex};
+			stopping = false;
+			current = generation;
+		}
+
+		workers.reserve(threads);
+		for (unsigned i = 0; i < threads; ++i)
+			workers.emplace([this, current] { workerLoop(current); });
+	}
+
+	void stop()
+	{
+		{
+			std::lock_guard<std::mutex> lock{mutex};
+			stopping = true;
+		}
+		wake.notify_all();
+
+		for (unsigned i = 0; i < workers.getSize(); ++i)
+			workers[i].join();
+		workers = DynamicArray<std::thread>{};
+	}
+
+public:
+	explicit ThreadPool(unsigned threads) { start(threads); }
+
+	ThreadPool(ThreadPool const&) = delete;
+	ThreadPool& operator=(ThreadPool const&) = delete;
+
+	/*
+	 * The pool shared by the whole program. It starts with one worker less
+	 * than the number of CPU cores (the caller is the last one); change it
+	 * with resize().
+	 */
+	static ThreadPool& shared()
+	{
+		static ThreadPool pool{std::thread::hardware_concurrency() > 1
+		                           ? std::thread::hardware_concurrency() - 1
+		                           : 0};
+		return pool;
+	}
+
+	unsigned getWorkers() const { return workers.getSize(); }
+
+	// Restarts the pool with a different number of workers.
+	void resize(unsigned threads)
+	{
+		std::lock_guard<std::mutex> lock{submitMutex};
+		stop();
+		start(threads);
+	}
+
+	/*
+	 * Calls `task(i)` for every i in [0, count), spread over the workers and
+	 * the calling thread, and returns when all calls are done. The order of
+	 * the calls is unspecified - results must not depend on it.
+	 */
+	template <typename Task> void parallelFor(unsigned count, Task const& task)
+	{
+		if (count == 0) return;
+		if (workers.getSize() == 0 || count == 1) {
+			for (unsigned i = 0; i < count; ++i)
+				task(i);
+			return;
+		}
+
+		std::lock_guard<std::mutex> submitLock{submitMutex};
+		{
+			std::lock_guard<std::mutex> lock{mutex};
+			invoke = [](void* context, unsigned i) {
+				(*static_cast<Task const*>(context))(i);
+			};
+			context = const_cast<Task*>(&task);
+			jobSize = count;
+			nextIndex = 0;
+			busyWorkers = workers.getSize();
+			generation++;
+		}
+		wake.notify_all();
+
+		runTasks();
+
+		std::unique_lock<std::mutex> lock{mutex};
+		done.wait(lock, [&] { return busyWorkers == 0; });
+	}
+
+	~ThreadPool() { stop(); }
+};
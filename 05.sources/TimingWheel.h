@@ -0,0 +1,98 @@
+#pragma once
+
+#include "DynamicArray.h"
+
+/*
+ * Events which are due at given (integer) times, e.g. "person 17 gets
+ * symptoms at time 120". Advancing the clock fires the events that became
+ * due, and looks at nothing else - so a clock step costs about as much as
+ * the events it fires, not as much as all the events waiting.
+ *
+ *     TimingWheel<unsigned> wheel;
+ *     wheel.schedule(120, 17);
+ *     wheel.advanceTo(now, [&](unsigned due, unsigned person) { ... });
+ *
+ * The events are kept in a ring of `slots` buckets ("timing wheel"): an
+ * event due at time t goes to bucket t % slots, and a step to time t only
+ * looks at that bucket. An event more than `slots` steps ahead waits in its
+ * bucket for a few turns of the wheel ("calendar queue") - so pick about as
+ * many slots as the usual delay.
+ *
+ * Events due at the same time fire in the order in which they were
+ * scheduled. Like SpatialGrid, the memory of the buckets is kept.
+ */
+template <typename T> class TimingWheel
+{
+	struct Event
+	{
+		unsigned due;
+		T value;
+	};
+
+	DynamicArray<DynamicArray<Event>> buckets;
+	unsigned mask;    // The number of buckets - 1 (a power of two).
+	unsigned now = 0; // Every event due up to now has fired.
+	unsigned size = 0;
+
+public:
+	explicit TimingWheel(unsigned slots = 256)
+	{
+		unsigned count = 1;
+		while (count < slots)
+			count *= 2;
+		buckets = DynamicArray<DynamicArray<Event>>(count);
+		mask = count - 1;
+	}
+
+	unsigned getTime() const { return now; }
+
+	// The number of events which haven't fired yet.
+	unsigned getSize() const { return size; }
+
+	/*
+	 * Adds an event, to fire at time `due`. An event due at or before the
+	 * current time fires at the next step of the clock, with its `due`.
+	 */
+	void schedule(unsigned due, T const& value)
+	{
+		unsigned at = due > now ? due : now + 1;
+		buckets[at & mask].push(Event{due, value});
+		size++;
+	}
+
+	/*
+	 * Steps the clock up to `time`, calling `fire(due, value)` for every
+	 * event due by then, in the order of their due times. `fire` may
+	 * schedule new events.
+	 */
+	template <typename Fire> void advanceTo(unsigned time, Fire fire)
+	{
+		for (; now < time;) {
+			DynamicArray<Event>& bucket = buckets[++now & mask];
+
+			// The events which aren't due yet are kept, in order.
+			// NOTE: `fire` may add events to this very bucket (and grow
+			// it), so it is indexed anew every time.
+			unsigned kept = 0;
+			for (unsigned k = 0; k < bucket.getSize(); ++k) {
+				Event event = bucket[k];
+				if (event.due <= now) {
+					size--;
+					fire(event.due, event.value);
+				} else {
+					bucket[kept++] = event;
+				}
+			}
+			bucket.deleteRange(kept, bucket.getSize() - kept);
+		}
+	}
+
+	// Removes every event and sets the clock to `time`.
+	void clear(unsigned time = 0)
+	{
+		for (unsigned b = 0; b < buckets.getSize(); ++b)
+			buckets[b].deleteRange(0, buckets[b].getSize());
+		now = time;
+		size = 0;
+	}
+};
@@ -0,0 +1,147 @@
+#pragma once
+
+#include "City.h"
+#include "DynamicArray.h"
+#include "Person.h"
+#include "Random.h"
+#include "ThreadPool.h"
+#include <cstdint>
+
+/*
+ * Someone on their way from one city to another (by "teleportation": they
+ * keep their position and health, only the city changes).
+ */
+struct Traveler
+{
+	unsigned to; // The index of the destination city.
+	PersonLocation loc;
+	HealthState healthState;
+};
+
+/*
+ * Many cities, e.g. a whole country:
+ *
+ *     World world{300, seed};
+ *     world[0].people.push(Person{world[0], loc, health});
+ *     ThreadPool pool{7};
+ *     world.pool = &pool;
+ *     world.update(1);
+ *
+ * A tick runs every city's City::update() as one task on `pool`, so the
+ * cities are spread over the cores. The cities don't touch each other
+ * during a tick: a city only *sends* its travelers, into its own outbox.
+ * After all cities are done, the travelers are delivered - the outboxes in
+ * the order of the cities, each in the order it was filled. So the result
+ * is the same on any number of threads.
+ *
+ * NOTE: The cities tick in step, so the times in a HealthState (see
+ * City::time) mean the same in every city, and travel with the person.
+ * NOTE: A World runs its cities on its own pool; City::pool of its cities
+ * must stay null (a task of a pool can't use the same pool).
+ * NOTE: The cities never move in memory (every Person holds a City&), so a
+ * World has a fixed number of cities and can't be copied.
+ */
+class World
+{
+	DynamicArray<City> cities;
+	DynamicArray<DynamicArray<Traveler>> outboxes; // One per city.
+
+	// Each city's travel decisions come from a stream separate from those
+	// of its people (see City::update()).
+	static constexpr std::uint64_t TRAVEL_SEED = 0x7472617665ull;
+
+	// Moves the people of city `c` who leave in this tick into its outbox.
+	void sendTravelers(unsigned c)
+	{
+		City& city = cities[c];
+		DynamicArray<Traveler>& outbox = outboxes[c];
+		outbox.deleteRange(0, outbox.getSize());
+		if (cities.getSize() < 2) return;
+
+		// NOTE: From the back, so that deleteAtUnordered() only moves people
+		// who have had their turn. It changes the index of one person, who
+		// then needs their health transition scheduled again.
+		RandomStream random{city.seed ^ TRAVEL_SEED, city.tick};
+		for (unsigned i = city.people.getSize(); i-- > 0;) {
+			Person& person = city.people[i];
+			if (person.loc.checkIfHome()) continue;
+			if (!bernoulli(random, travelRate)) continue;
+
+			// Any other city: 32 random bits scaled to [0, cities - 1).
+			unsigned to =
+			    unsigned((random() >> 32) * (cities.getSize() - 1) >> 32);
+			if (to >= c) to++;
+
+			outbox.push(Traveler{to, person.loc, person.healthState});
+			city.people.deleteAtUnordered(i);
+			if (i < city.people.getSize()) city.scheduleHealth(i);
+		}
+	}
+
+	void deliverTravelers()
+	{
+		for (unsigned c = 0; c < outboxes.getSize(); ++c) {
+			for (unsigned t = 0; t < outboxes[c].getSize(); ++t) {
+				Traveler& traveler = outboxes[c][t];
+				City& to = cities[traveler.to];
+				to.people.push(Person{to, traveler.loc, traveler.healthState});
+				to.scheduleHealth(to.people.getSize() - 1);
+			}
+		}
+	}
+
+public:
+	// The chance of each person who is outside to leave for another city,
+	// per tick.
+	float travelRate = 0.001f;
+
+	// Where update() runs; null runs it on the calling thread.
+	ThreadPool* pool = nullptr;
+
+	// `count` empty cities, each with its own seed derived from `seed`.
+	explicit World(unsigned count, std::uint64_t seed = 0)
+	    : cities(count), outboxes(count)
+	{
+		for (unsigned c = 0; c < count; ++c)
+			cities[c].seed = mixBits(seed + c);
+	}
+
+	World(World const&) = delete;
+	World& operator=(World const&) = delete;
+
+	unsigned getSize() const { return cities.getSize(); }
+
+	City& operator[](unsigned i) { return cities[i]; }
+	City const& operator[](unsigned i) const { return cities[i]; }
+
+	unsigned getPopulation() const
+	{
+		unsigned total = 0;
+		for (unsigned c = 0; c < cities.getSize(); ++c)
+			total += cities[c].people.getSize();
+		return total;
+	}
+
+	/*
+	 * One tick of every city, then the travel between them. The travelers
+	 * arrive at the end of the tick, so they are first updated in their new
+	 * city in the next one.
+	 * NOTE: The delivery is serial, but it only copies the travelers - a
+	 * small fraction of the people.
+	 */
+	void update(unsigned deltaTime)
+	{
+		auto tick = [&](unsigned c) {
+			cities[c].update(deltaTime);
+			sendTravelers(c);
+		};
+
+		if (pool)
+			pool->parallelFor(cities.getSize(), tick);
+		else
+			for (unsigned c = 0; c < cities.getSize(); ++c)
+				tick(c);
+
+		deliverTravelers();
+	}
+};
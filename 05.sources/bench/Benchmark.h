@@ -0,0 +1,101 @@
+#pragma once
+
+#include "../DynamicArray.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+/*
+ * Runs `f` once and returns how long it took, in seconds.
+ */
+template <typename F> double timeIt(F f)
+{
+	auto start = std::chrono::steady_clock::now();
+	f();
+	std::chrono::duration<double> elapsed =
+	    std::chrono::steady_clock::now() - start;
+	return elapsed.count();
+}
+
+/*
+ * Runs `setup` and then `f` `repeats` times and returns the fastest run of
+ * `f`, in seconds. The first runs also warm up caches and page tables.
+ */
+template <typename Setup, typename F>
+double bestOf(unsigned repeats, Setup setup, F f)
+{
+	double best = 0;
+	for (unsigned i = 0; i < repeats; ++i) {
+		setup();
+		double seconds = timeIt(f);
+		if (i == 0 || seconds < best) best = seconds;
+	}
+	return best;
+}
+
+/*
+ * Keeps the optimizer from throwing away a computation whose result we
+ * don't otherwise use.
+ */
+template <typename T> void doNotOptimize(T const& value)
+{
+	asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/*
+ * The distribution of the run times of a benchmark, in seconds.
+ */
+struct Stats
+{
+	unsigned samples;
+	double median;
+	double p99; // 99% of the runs were at least this fast.
+	double min, max;
+};
+
+/*
+ * Runs `f` `warmups` times unmeasured, then `samples` times measured, with
+ * `setup` (unmeasured) before every run.
+ */
+template <typename Setup, typename F>
+Stats measure(unsigned warmups, unsigned samples, Setup setup, F f)
+{
+	for (unsigned i = 0; i < warmups; ++i) {
+		setup();
+		f();
+	}
+
+	DynamicArray<double> times;
+	times.reserve(samples);
+	for (unsigned i = 0; i < samples; ++i) {
+		setup();
+		times.push(timeIt(f));
+	}
+	std::sort(&times[0], &times[0] + samples);
+
+	// The "nearest rank": the smallest time with at least p% of the runs at
+	// or below it.
+	auto percentile = [&](unsigned p) {
+		unsigned rank = (samples * p + 99) / 100;
+		return times[rank ? rank - 1 : 0];
+	};
+	return Stats{samples, percentile(50), percentile(99), times[0],
+	             times[samples - 1]};
+}
+
+/*
+ * Prints one line of JSON per benchmark ("JSON Lines"), easy to compare
+ * between runs with any script. `operations` is the work done by one run
+ * (e.g. the number of elements pushed); the throughput is per second, at the
+ * median time.
+ */
+inline void printJson(const char* name, unsigned size, double operations,
+                      Stats const& stats)
+{
+	std::printf("{\"name\": \"%s\", \"size\": %u, \"samples\": %u, "
+	            "\"median_ns\": %.0f, \"p99_ns\": %.0f, \"min_ns\": %.0f, "
+	            "\"max_ns\": %.0f, \"ops_per_s\": %.6g}\n",
+	            name, size, stats.samples, stats.median * 1e9, stats.p99 * 1e9,
+	            stats.min * 1e9, stats.max * 1e9, operations / stats.median);
+	std::fflush(stdout);
+}
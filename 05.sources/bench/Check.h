@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdio>
+
+/*
+ * The bits shared by the programs which check rather than measure, e.g.
+ * MatrixViews.c++:
+ *
+ *     expect(result.get(0, 1) == 3, "A = A.transposed()");
+ *     ...
+ *     return report();
+ *
+ * Every failed expectation is printed to stderr; report() returns the exit
+ * status of the program - 1 if anything failed.
+ */
+
+inline unsigned& failures()
+{
+	static unsigned count = 0;
+	return count;
+}
+
+inline void expect(bool ok, const char* what)
+{
+	if (ok) return;
+	std::fprintf(stderr, "FAILED: %s\n", what);
+	failures()++;
+}
+
+// Whether `f()` throws an E.
+template <typename E, typename F> bool throws(F f)
+{
+	try {
+		f();
+	} catch (E const&) {
+		return true;
+	}
+	return false;
+}
+
+inline int report()
+{
+	if (failures()) return 1;
+	std::printf("ok\n");
+	return 0;
+}
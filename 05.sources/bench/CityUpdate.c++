@@ -0,0 +1,56 @@
+#include "../City.h"
+#include "Benchmark.h"
+#include "Fixtures.h"
+#include <cstdio>
+
+/*
+ * City::update() on 1, 2 and 4 threads: the time of TICKS ticks, and
+ * whether the city ends up in exactly the same state on every number of
+ * threads. If it doesn't, the program says so and fails.
+ *
+ * NOTE: All three also on fewer cores - the threads then take turns, which
+ * says nothing about the speed-up but still checks the determinism.
+ *
+ *     g++ -std=c++17 -O2 -pthread CityUpdate.c++ ../Person.c++ -o update
+ */
+
+using namespace std;
+
+const unsigned WARMUPS = 1;
+const unsigned SAMPLES = 5;
+const unsigned TICKS = 10;
+
+int main()
+{
+	for (unsigned n : {10000u, 100000u, 1000000u}) {
+		unsigned long long expected = 0;
+
+		for (unsigned threads : {1u, 2u, 4u}) {
+			// The calling thread works too.
+			ThreadPool pool{threads - 1};
+			City city;
+			city.pool = &pool;
+			city.seed = 42;
+
+			char name[64];
+			std::snprintf(name, sizeof name, "City::update/threads=%u",
+			              threads);
+			auto setup = [&] { populate(city, n, sideFor(n)); };
+			printJson(name, n, double(n) * TICKS,
+			          measure(WARMUPS, SAMPLES, setup, [&] {
+				          for (unsigned t = 0; t < TICKS; ++t)
+					          city.update(1);
+			          }));
+
+			unsigned long long hash = fingerprint(city);
+			if (threads == 1) expected = hash;
+			if (hash != expected) {
+				std::fprintf(stderr, "%u people, %u threads: the result "
+				                     "differs from 1 thread\n",
+				             n, threads);
+				return 1;
+			}
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,136 @@
+#include "../ConcurrentArray.h"
+#include "../DynamicArray.h"
+#include "Benchmark.h"
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+
+/*
+ * Many threads appending to one array: ConcurrentArray against a
+ * DynamicArray guarded by a mutex, at 1, 2, 4, ... threads - up to the
+ * number of CPU cores, but at least 4.
+ *
+ *     g++ -std=c++17 -O2 -pthread ConcurrentArray.c++ -o concurrent
+ *
+ * Before timing, a stress test checks that every pushed element is there
+ * exactly once and that no element moved while the others were pushed.
+ * In the output, "size" is the number of threads.
+ */
+
+using namespace std;
+
+const unsigned PUSHES = 1000000; // In total, split over the threads.
+const unsigned WARMUPS = 1;
+const unsigned SAMPLES = 11;
+
+struct Event
+{
+	unsigned thread, sequence;
+};
+
+// A DynamicArray made thread-safe the simple way.
+struct LockedArray
+{
+	mutex lock;
+	DynamicArray<Event> array;
+
+	void push(Event const& event)
+	{
+		lock_guard<mutex> guard{lock};
+		array.push(event);
+	}
+};
+
+// Runs `f(t)` on `threads` threads at once and waits for all of them.
+template <typename F> void runThreads(unsigned threads, F const& f)
+{
+	DynamicArray<thread> running;
+	for (unsigned t = 0; t < threads; ++t)
+		running.emplace([&f, t] { f(t); });
+	for (unsigned t = 0; t < threads; ++t)
+		running[t].join();
+}
+
+void fail(const char* what)
+{
+	fprintf(stderr, "Stress test failed: %s\n", what);
+	exit(1);
+}
+
+void stressTest(unsigned threads)
+{
+	ConcurrentArray<Event> events;
+	unsigned perThread = PUSHES / threads;
+
+	// Each thread remembers where its elements are, and checks them all
+	// again at the end: they must not have moved or changed.
+	DynamicArray<DynamicArray<Event*>> addresses(threads);
+	runThreads(threads, [&](unsigned t) {
+		for (unsigned i = 0; i < perThread; ++i) {
+			unsigned index = events.push(Event{t, i});
+			if (events[index].thread != t || events[index].sequence != i)
+				fail("an element differs right after push()");
+			addresses[t].push(&events[index]);
+		}
+	});
+
+	if (events.getSize() != perThread * threads) fail("wrong size");
+
+	DynamicArray<unsigned> seen(threads);
+	for (unsigned i = 0; i < events.getSize(); ++i) {
+		Event const& e = events[i];
+		if (e.thread >= threads || e.sequence >= perThread) fail("garbage");
+		if (addresses[e.thread][e.sequence] != &e) fail("an element moved");
+		seen[e.thread]++;
+	}
+	for (unsigned t = 0; t < threads; ++t)
+		if (seen[t] != perThread) fail("lost or duplicated elements");
+}
+
+int main()
+{
+	unsigned maxThreads = thread::hardware_concurrency();
+	if (maxThreads < 4) maxThreads = 4;
+
+	for (unsigned threads = 1; threads <= maxThreads; threads *= 2)
+		stressTest(threads);
+
+	for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+		unsigned perThread = PUSHES / threads;
+
+		ConcurrentArray<Event>* concurrent = nullptr;
+		printJson("ConcurrentArray::push", threads, perThread * threads,
+		          measure(
+		              WARMUPS, SAMPLES,
+		              [&] {
+			              delete concurrent;
+			              concurrent = new ConcurrentArray<Event>;
+		              },
+		              [&] {
+			              runThreads(threads, [&](unsigned t) {
+				              for (unsigned i = 0; i < perThread; ++i)
+					              concurrent->push(Event{t, i});
+			              });
+		              }));
+		delete concurrent;
+
+		LockedArray* locked = nullptr;
+		printJson("mutex+DynamicArray::push", threads, perThread * threads,
+		          measure(
+		              WARMUPS, SAMPLES,
+		              [&] {
+			              delete locked;
+			              locked = new LockedArray;
+		              },
+		              [&] {
+			              runThreads(threads, [&](unsigned t) {
+				              for (unsigned i = 0; i < perThread; ++i)
+					              locked->push(Event{t, i});
+			              });
+		              }));
+		delete locked;
+	}
+
+	return 0;
+}
@@ -0,0 +1,190 @@
+#include "../Allocator.h"
+#include "../DynamicArray.h"
+#include "../Matrix.h"
+#include <cstdio>
+#include <stdexcept>
+
+/*
+ * Not a benchmark, but a check: DynamicArray and Matrix destroy exactly what
+ * they constructed and free what they allocated, also when an element's
+ * constructor throws half-way. If anything leaks, the program says so and
+ * fails.
+ *
+ *     g++ -std=c++17 -O2 CountedConstruction.c++ -o counted
+ *
+ * Counted counts its live objects, and throws from the constructor which
+ * makes object number `throwAt` (counted from 1; 0 never throws).
+ * CountingAllocator counts the blocks not freed yet.
+ */
+
+using namespace std;
+
+const unsigned N = 100;
+
+struct Counted
+{
+	static int live;
+	static unsigned made, throwAt;
+
+	int value = 0;
+
+	static void count()
+	{
+		if (++made == throwAt) throw runtime_error("Counted");
+		live++;
+	}
+
+	Counted() { count(); }
+	Counted(Counted const& other) : value{other.value} { count(); }
+	Counted& operator=(Counted const&) = default;
+	~Counted() { live--; }
+};
+
+int Counted::live = 0;
+unsigned Counted::made = 0, Counted::throwAt = 0;
+
+struct CountingAllocator
+{
+	static int blocks;
+
+	void* allocate(size_t bytes, size_t alignment)
+	{
+		void* p = MallocAllocator{}.allocate(bytes, alignment);
+		blocks++;
+		return p;
+	}
+
+	void deallocate(void* p, size_t bytes)
+	{
+		if (p) blocks--;
+		MallocAllocator{}.deallocate(p, bytes);
+	}
+
+	void* reallocate(void* p, size_t oldBytes, size_t newBytes,
+	                 size_t alignment)
+	{
+		if (!p) blocks++;
+		return MallocAllocator{}.reallocate(p, oldBytes, newBytes, alignment);
+	}
+};
+
+int CountingAllocator::blocks = 0;
+
+using Array = DynamicArray<Counted, CountingAllocator>;
+using Grid = Matrix<Counted, CountingAllocator>;
+
+// The sides of the matrices.
+const unsigned R = 10, C = 10;
+
+unsigned failures = 0;
+
+void expect(bool ok, const char* what, unsigned throwAt)
+{
+	if (ok) return;
+	fprintf(stderr, "FAILED: %s (throwing at object %u)\n", what, throwAt);
+	failures++;
+}
+
+// Runs `f` with the `throwAt`-th construction throwing; returns whether it
+// threw.
+template <typename F> bool throwing(unsigned throwAt, F f)
+{
+	Counted::made = 0;
+	Counted::throwAt = throwAt;
+	bool threw = false;
+	try {
+		f();
+	} catch (runtime_error const&) {
+		threw = true;
+	}
+	Counted::throwAt = 0;
+	return threw;
+}
+
+int main()
+{
+	// DynamicArray(n): every element made is destroyed, and the block freed.
+	for (unsigned k = 0; k <= N; ++k) {
+		bool threw = throwing(k, [] {
+			Array array(N);
+			if (array.getSize() != N || Counted::live != int(N))
+				throw logic_error("DynamicArray(n)");
+		});
+		expect(threw == (k != 0), "DynamicArray(n) throws", k);
+		expect(Counted::live == 0, "DynamicArray(n) destroys", k);
+		expect(CountingAllocator::blocks == 0, "DynamicArray(n) frees", k);
+	}
+
+	// The copy constructor: the same, and the source is left alone.
+	for (unsigned k = 0; k <= N; ++k) {
+		{
+			Array source(N);
+			bool threw = throwing(k, [&] { Array copy{source}; });
+			expect(threw == (k != 0), "copy throws", k);
+			expect(Counted::live == int(N), "copy destroys", k);
+			expect(CountingAllocator::blocks == 1, "copy frees", k);
+		}
+		expect(Counted::live == 0, "~DynamicArray destroys", k);
+		expect(CountingAllocator::blocks == 0, "~DynamicArray frees", k);
+	}
+
+	// Growing copies the elements (Counted can't be moved without a
+	// throwing copy): if one copy throws, the array is as it was.
+	for (unsigned k = 0; k <= N; ++k) {
+		{
+			Array array(N);
+			array[N - 1].value = 7;
+			bool threw = throwing(k, [&] { array.reserve(2 * N); });
+			expect(threw == (k != 0), "reserve throws", k);
+			expect(Counted::live == int(N), "reserve destroys", k);
+			expect(CountingAllocator::blocks == 1, "reserve frees", k);
+			expect(array.getSize() == N && array[N - 1].value == 7,
+			       "reserve keeps the elements", k);
+		}
+		expect(Counted::live == 0, "~DynamicArray destroys", k);
+	}
+
+	// Matrix(rows, cols): the same as DynamicArray(n).
+	for (unsigned k = 0; k <= R * C; ++k) {
+		bool threw = throwing(k, [] { Grid grid(R, C); });
+		expect(threw == (k != 0), "Matrix(rows, cols) throws", k);
+		expect(Counted::live == 0, "Matrix(rows, cols) destroys", k);
+		expect(CountingAllocator::blocks == 0, "Matrix(rows, cols) frees", k);
+	}
+
+	// The copy constructor of Matrix.
+	for (unsigned k = 0; k <= R * C; ++k) {
+		{
+			Grid source(R, C);
+			bool threw = throwing(k, [&] { Grid copy{source}; });
+			expect(threw == (k != 0), "Matrix copy throws", k);
+			expect(Counted::live == int(R * C), "Matrix copy destroys", k);
+			expect(CountingAllocator::blocks == 1, "Matrix copy frees", k);
+		}
+		expect(Counted::live == 0, "~Matrix destroys", k);
+		expect(CountingAllocator::blocks == 0, "~Matrix frees", k);
+	}
+
+	// addRow() and addColumn(): a failed one leaves the matrix as it was.
+	for (unsigned k = 0; k <= R; ++k) {
+		{
+			Grid grid(R, C);
+			grid.reserve(R + 1, C + 1);
+			bool threw = throwing(k, [&] { grid.addColumn(); });
+			expect(threw == (k != 0), "addColumn() throws", k);
+			expect(Counted::live == int(R * grid.getCols()),
+			       "addColumn() destroys", k);
+
+			threw = throwing(k, [&] { grid.addRow(); });
+			expect(threw == (k != 0), "addRow() throws", k);
+			expect(Counted::live == int(grid.getRows() * grid.getCols()),
+			       "addRow() destroys", k);
+		}
+		expect(Counted::live == 0, "~Matrix destroys", k);
+		expect(CountingAllocator::blocks == 0, "~Matrix frees", k);
+	}
+
+	if (failures) return 1;
+	printf("ok\n");
+	return 0;
+}
@@ -0,0 +1,79 @@
+#include "../DynamicArray.h"
+#include "../Position.h"
+#include "Benchmark.h"
+#include <iostream>
+
+using namespace std;
+
+// Same bytes as Position, but the hand-written copy constructor makes it
+// non-trivially copyable, so DynamicArray takes the element-by-element path.
+struct GenericPosition
+{
+	Position pos;
+
+	GenericPosition(Position const& pos) : pos(pos) {}
+	GenericPosition(GenericPosition const& other) : pos(other.pos) {}
+	GenericPosition& operator=(GenericPosition const& other)
+	{
+		pos = other.pos;
+		return *this;
+	}
+};
+
+const unsigned N = 10000000;
+const unsigned REPEATS = 5;
+
+// Prints the throughput of one operation over N elements.
+void report(const char* type, const char* operation, double seconds)
+{
+	cout << type << "\t" << operation << "\t" << (N / seconds / 1e6)
+	     << " M elements/s" << endl;
+}
+
+template <typename T> void fill(DynamicArray<T>& array)
+{
+	array = DynamicArray<T>{};
+	for (unsigned i = 0; i < N; ++i)
+		array.push(Position{float(i), float(i), 0});
+}
+
+template <typename T> void run(const char* type)
+{
+	DynamicArray<T> array, other;
+
+	report(type, "push", bestOf(REPEATS, [&] { array = DynamicArray<T>{}; },
+	                            [&] { fill(array); }));
+
+	report(type, "copy", bestOf(REPEATS, [&] { other = DynamicArray<T>{}; },
+	                            [&] { other = array; }));
+
+	report(type, "extendWith",
+	       bestOf(REPEATS,
+	              [&] {
+		              other = DynamicArray<T>{};
+		              other.reserve(2 * N);
+	              },
+	              [&] { other.extendWith(array); }));
+
+	// Removing the front element shifts the remaining N - 1 elements.
+	report(type, "deleteRange",
+	       bestOf(REPEATS, [&] { other = array; },
+	              [&] { other.deleteRange(0, 1); }));
+
+	report(type, "shrink_to_fit",
+	       bestOf(REPEATS,
+	              [&] {
+		              other = array;
+		              other.reserve(2 * N);
+	              },
+	              [&] { other.shrink_to_fit(); }));
+
+	doNotOptimize(other[0]);
+}
+
+int main()
+{
+	run<Position>("trivial");
+	run<GenericPosition>("generic");
+	return 0;
+}
@@ -0,0 +1,92 @@
+#include "../FixedMatrix.h"
+#include "../Matrix.h"
+#include "Check.h"
+#include <cmath>
+#include <stdexcept>
+
+/*
+ * Not a benchmark, but a check of FixedMatrix.h: what its comments promise
+ * at compile time is checked with static_assert, the inverses at run time.
+ *
+ *     g++ -std=c++17 -O2 FixedMatrix.c++ -o fixed
+ */
+
+using namespace std;
+
+// ---- At compile time -------------------------------------------------------
+
+constexpr FixedMatrix<float, 2, 2> rotate90{0, -1,
+                                            1, 0};
+static_assert(rotate90 * rotate90 * rotate90 * rotate90 ==
+              FixedMatrix<float, 2, 2>::identity());
+static_assert(rotate90 * rotate90 == -FixedMatrix<float, 2, 2>::identity());
+static_assert(transpose(rotate90) == rotate90 * -1.0f);
+
+constexpr FixedMatrix<int, 2, 3> wide{1, 2, 3,
+                                      4, 5, 6};
+static_assert(wide * transpose(wide) == FixedMatrix<int, 2, 2>{14, 32,
+                                                               32, 77});
+static_assert(determinant(FixedMatrix<double, 3, 3>{2, 0, 0,
+                                                    0, 3, 0,
+                                                    1, 1, 4}) == 24);
+static_assert(inverse(FixedMatrix<double, 2, 2>{1, 2,
+                                                0, 1}) ==
+              FixedMatrix<double, 2, 2>{1, -2,
+                                        0, 1});
+
+// ---- At run time ----------------------------------------------------------
+
+// The largest |m(i, j) - I(i, j)|.
+template <unsigned N> double distanceToIdentity(FixedMatrix<double, N, N> m)
+{
+	double worst = 0;
+	for (unsigned i = 0; i < N; ++i)
+		for (unsigned j = 0; j < N; ++j)
+			worst = max(worst, fabs(m.get(i, j) - (i == j ? 1.0 : 0.0)));
+	return worst;
+}
+
+int main()
+{
+	// The closed formula.
+	FixedMatrix<double, 4, 4> m4{4, 7, 2, 3,
+	                             0, 5, 1, 9,
+	                             8, 1, 6, 2,
+	                             3, 3, 0, 7};
+	expect(distanceToIdentity(m4 * inverse(m4)) < 1e-12, "4x4 inverse");
+	expect(distanceToIdentity(inverse(m4) * m4) < 1e-12, "4x4 inverse, left");
+
+	// Gauss-Jordan. The first pivot is 0, so the rows must be swapped.
+	FixedMatrix<double, 5, 5> m5{0, 2, 1, 4, 3,
+	                             5, 1, 0, 2, 8,
+	                             1, 7, 3, 0, 2,
+	                             6, 0, 9, 1, 1,
+	                             2, 4, 1, 8, 0};
+	expect(distanceToIdentity(m5 * inverse(m5)) < 1e-12, "5x5 inverse");
+	expect(fabs(determinant(m5) * determinant(inverse(m5)) - 1) < 1e-12,
+	       "5x5 determinant");
+
+	FixedMatrix<double, 5, 5> singular{};
+	expect(throws<runtime_error>([&] { inverse(singular); }),
+	       "a singular 5x5 matrix throws");
+	expect(throws<runtime_error>([] {
+		       inverse(FixedMatrix<double, 4, 4>{1, 2, 3, 4,
+		                                         2, 4, 6, 8,
+		                                         0, 1, 0, 1,
+		                                         1, 0, 1, 0});
+	       }),
+	       "a singular 4x4 matrix throws");
+
+	// To a Matrix and back.
+	Matrix<double> dynamic{m4};
+	expect(dynamic.getRows() == 4 && dynamic.get(1, 3) == 9,
+	       "Matrix from FixedMatrix");
+	dynamic = dynamic * 2;
+	expect(FixedMatrix<double, 4, 4>::from(dynamic) == m4 * 2.0,
+	       "FixedMatrix from Matrix");
+	expect(throws<runtime_error>(
+	           [&] { FixedMatrix<double, 3, 3>::from(dynamic); }),
+	       "FixedMatrix from a Matrix of another size throws");
+
+	return report();
+}
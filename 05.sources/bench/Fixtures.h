@@ -0,0 +1,96 @@
+#pragma once
+
+#include "../City.h"
+#include <cmath>
+#include <cstdlib>
+
+/*
+ * The populations and checks the simulation benchmarks share, so that they
+ * all measure the same cities.
+ */
+
+// The side of a square with ~100 square units per person. At this density
+// a city grows with its population, like in a real country: more people,
+// more land.
+inline unsigned sideFor(unsigned people)
+{
+	return unsigned(std::sqrt(people * 100.0)) + 1;
+}
+
+/*
+ * Replaces the people of `city` by `n` new ones on a `side` x `side`
+ * square: a quarter stay home, 1% of them are ill. The positions come from
+ * rand(), seeded with `seed`, so every call with the same arguments makes
+ * the same people.
+ *
+ * NOTE: Also resets the clock of the city (tick and time), so that every
+ * run of a benchmark starts from the same state.
+ */
+inline void populate(City& city, unsigned n, unsigned side,
+                     unsigned seed = 42)
+{
+	srand(seed);
+	city.people = DynamicArray<Person>{};
+	city.people.reserve(n);
+	for (unsigned i = 0; i < n; ++i) {
+		PersonLocation loc;
+		if (i % 4 == 0)
+			loc.goHome();
+		else
+			loc.goOut(Position{float(rand() % side), float(rand() % side),
+			                   float(rand() % 628) / 100});
+
+		HealthState health{0, false, HealthState::HEALTHY, 0};
+		if (i % 100 == 1) health.infect(0);
+
+		city.people.push(Person{city, loc, health});
+	}
+	city.tick = 0;
+	city.time = 0;
+	city.rescheduleHealth();
+	city.rebuildIndex();
+}
+
+// The old City::hasSickPeopleAround(): a scan over everybody.
+inline bool scanForSick(City& city, Position const& pos, float radius)
+{
+	for (unsigned i = 0; i < city.people.getSize(); ++i) {
+		Person& other = city.people[i];
+		if (other.loc.checkIfHome()) continue;
+		if (other.healthState.healthState != HealthState::ILL) continue;
+		if (withinRadius(pos, other.loc.getPosition(), radius)) return true;
+	}
+	return false;
+}
+
+/*
+ * FNV-1a over everything City::update() may change, starting from `hash` -
+ * pass the result of the previous city to fold many cities into one.
+ */
+inline unsigned long long
+fingerprint(City& city, unsigned long long hash = 14695981039346656037ull)
+{
+	auto add = [&](void const* bytes, unsigned size) {
+		for (unsigned k = 0; k < size; ++k) {
+			hash ^= static_cast<unsigned char const*>(bytes)[k];
+			hash *= 1099511628211ull;
+		}
+	};
+
+	unsigned size = city.people.getSize();
+	add(&size, sizeof size);
+	for (unsigned i = 0; i < size; ++i) {
+		Person& person = city.people[i];
+		bool isHome = person.loc.checkIfHome();
+		add(&isHome, sizeof isHome);
+		if (!isHome) {
+			Position pos = person.loc.getPosition();
+			add(&pos, sizeof pos);
+		}
+		add(&person.healthState.infectedAt, sizeof(unsigned));
+		add(&person.healthState.hasSympoms, sizeof(bool));
+		add(&person.healthState.healthState,
+		    sizeof person.healthState.healthState);
+	}
+	return hash;
+}
@@ -0,0 +1,101 @@
+#include "../MappedFile.h"
+#include "Check.h"
+#include <cstdio>
+#include <cstring>
+
+/*
+ * Not a benchmark, but a check: what saveBinary() writes, MappedArray and
+ * MappedMatrix read back as it was, and a file which does not hold what it
+ * is opened as is refused with an error naming the file.
+ *
+ *     g++ -std=c++17 -O2 MappedFile.c++ -o mapped
+ *
+ * NOTE: Writes its files to the current directory, and removes them.
+ */
+
+using namespace std;
+
+const char* const ARRAY = "mapped-check-array.bin";
+const char* const MATRIX = "mapped-check-matrix.bin";
+
+struct Sample
+{
+	float x, y;
+	unsigned id;
+};
+
+// Whether opening `path` as an M throws a runtime_error which names `path`
+// and says `why`.
+template <typename M> bool refuses(const char* path, const char* why)
+{
+	try {
+		M mapped{path};
+	} catch (runtime_error const& e) {
+		return strstr(e.what(), path) && strstr(e.what(), why);
+	}
+	return false;
+}
+
+int main()
+{
+	{
+		DynamicArray<Sample> array;
+		for (unsigned i = 0; i < 1000; ++i)
+			array.push(Sample{i * 0.5f, -float(i), i});
+		saveBinary(array, ARRAY);
+
+		MappedArray<Sample> mapped{ARRAY};
+		bool same = mapped.getSize() == array.getSize();
+		for (unsigned i = 0; same && i < array.getSize(); ++i)
+			same = memcmp(&mapped[i], &array[i], sizeof(Sample)) == 0;
+		expect(same, "MappedArray reads what saveBinary() wrote");
+
+		DynamicArray<Sample> copy = mapped.toDynamicArray();
+		expect(copy.getSize() == 1000 && copy[999].id == 999,
+		       "MappedArray::toDynamicArray()");
+	}
+	{
+		Matrix<double> matrix{37, 21};
+		for (unsigned i = 0; i < matrix.getRows(); ++i)
+			for (unsigned j = 0; j < matrix.getCols(); ++j)
+				matrix.set(i, j, i * 100.0 + j / 8.0);
+		saveBinary(matrix, MATRIX);
+
+		MappedMatrix<double> mapped{MATRIX};
+		bool same = mapped.getRows() == matrix.getRows() &&
+		            mapped.getCols() == matrix.getCols();
+		for (unsigned i = 0; same && i < matrix.getRows(); ++i)
+			for (unsigned j = 0; same && j < matrix.getCols(); ++j)
+				same = mapped.at(i, j) == matrix.get(i, j);
+		expect(same, "MappedMatrix reads what saveBinary() wrote");
+
+		Matrix<double> sum = mapped + matrix;
+		expect(sum.get(36, 20) == 2 * matrix.get(36, 20),
+		       "MappedMatrix in an expression");
+	}
+
+	// The wrong kind of numbers, of the right size.
+	expect(refuses<MappedMatrix<int64_t>>(MATRIX, "wrong element type"),
+	       "doubles read as int64_t");
+	expect(refuses<MappedArray<double>>(MATRIX, "not an array"),
+	       "a matrix read as an array");
+
+	// One element short.
+	expect(truncate(MATRIX, sizeof(FileHeader) + (37 * 21 - 1) * 8) == 0,
+	       "truncate()");
+	expect(refuses<MappedMatrix<double>>(MATRIX, "wrong file size"),
+	       "a truncated file");
+
+	// Not even a header.
+	expect(truncate(ARRAY, 10) == 0, "truncate()");
+	expect(refuses<MappedArray<Sample>>(ARRAY, "not a binary file"),
+	       "a file shorter than the header");
+
+	expect(refuses<MappedArray<Sample>>("mapped-check-missing.bin",
+	                                    "Can't open"),
+	       "a missing file");
+
+	remove(ARRAY);
+	remove(MATRIX);
+	return report();
+}
@@ -0,0 +1,42 @@
+#include "../Matrix.h"
+#include "../MatrixOperations.h"
+#include "Benchmark.h"
+#include <iostream>
+
+using namespace std;
+
+const unsigned N = 4096; // 128 MB per matrix of doubles - well beyond L3
+const unsigned REPEATS = 3;
+
+// Prints the time and the memory traffic of computing `A + B * 2 - C`, when
+// the whole computation reads or writes `passes` matrices' worth of memory.
+void report(const char* version, unsigned passes, double seconds)
+{
+	double bytes = double(passes) * N * N * sizeof(double);
+	cout << version << "\t" << seconds * 1000 << " ms\t" << bytes / 1e9
+	     << " GB moved\t" << bytes / seconds / 1e9 << " GB/s" << endl;
+}
+
+int main()
+{
+	Matrix<double> A{N, N}, B{N, N}, C{N, N}, R{N, N};
+	for (unsigned i = 0; i < N; ++i) {
+		for (unsigned j = 0; j < N; ++j) {
+			A.set(i, j, i + j);
+			B.set(i, j, i * 0.5);
+			C.set(i, j, j * 0.25);
+		}
+	}
+
+	// With eager operations every operator reads its operands and writes a
+	// new temporary: scale B (2 passes), add A (3), scale C (2), add (3).
+	report("eager", 10, bestOf(REPEATS, [] {}, [&] {
+		       R = add(add(A, scale(B, 2.0)), scale(C, -1.0));
+	       }));
+
+	// Fused: read A, B and C once, write R once.
+	report("fused", 4, bestOf(REPEATS, [] {}, [&] { R = A + B * 2 - C; }));
+
+	doNotOptimize(R.get(N - 1, N - 1));
+	return 0;
+}
@@ -0,0 +1,74 @@
+#include "../MatrixMultiply.h"
+#include "Benchmark.h"
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+using namespace std;
+
+const unsigned REPEATS = 3;
+
+template <typename T> Matrix<T> randomMatrix(unsigned rows, unsigned cols)
+{
+	Matrix<T> m{rows, cols};
+	for (unsigned i = 0; i < rows; ++i) {
+		for (unsigned j = 0; j < cols; ++j) {
+			m.set(i, j, T(rand() % 1000) / 1000);
+		}
+	}
+	return m;
+}
+
+template <typename T> T maxDifference(Matrix<T> const& a, Matrix<T> const& b)
+{
+	T diff = 0;
+	for (unsigned i = 0; i < a.getRows(); ++i) {
+		for (unsigned j = 0; j < a.getCols(); ++j) {
+			T d = std::abs(a.get(i, j) - b.get(i, j));
+			if (d > diff) diff = d;
+		}
+	}
+	return diff;
+}
+
+// Prints the speed of one multiplication of two n x n matrices.
+void report(const char* type, unsigned n, const char* version, double seconds)
+{
+	double flops = 2.0 * n * n * n;
+	cout << type << "\t" << n << "\t" << version << "\t"
+	     << flops / seconds / 1e9 << " GFLOP/s" << endl;
+}
+
+template <typename T> void run(const char* type, unsigned n)
+{
+	Matrix<T> a = randomMatrix<T>(n, n), b = randomMatrix<T>(n, n);
+	Matrix<T> expected = multiplyNaive(a, b), result;
+
+	report(type, n, "naive", bestOf(REPEATS, [] {}, [&] {
+		       result = multiplyNaive(a, b);
+	       }));
+
+	const char* names[] = {"blocked", "sse", "avx2"};
+	SimdLevel levels[] = {SimdLevel::SCALAR, SimdLevel::SSE, SimdLevel::AVX2};
+	for (unsigned l = 0; l < 3; ++l) {
+		if (levels[l] > detectSimdLevel()) continue;
+
+		report(type, n, names[l], bestOf(REPEATS, [] {}, [&] {
+			       result = multiply(a, b, levels[l]);
+		       }));
+
+		// Different summation order, so compare with a tolerance.
+		if (maxDifference(result, expected) > T(1e-3) * n)
+			cout << "\tWRONG RESULT: off by " << maxDifference(result, expected)
+			     << endl;
+	}
+}
+
+int main()
+{
+	for (unsigned n : {256, 512, 1024}) {
+		run<float>("float", n);
+		run<double>("double", n);
+	}
+	return 0;
+}
@@ -0,0 +1,72 @@
+#include "../Matrix.h"
+#include "Check.h"
+
+/*
+ * Not a benchmark, but a check: assigning an expression which reads the
+ * matrix itself - through a view in another layout, like a transpose or a
+ * block - gives the same result as assigning a copy.
+ *
+ *     g++ -std=c++17 -O2 MatrixViews.c++ -o views
+ */
+
+using namespace std;
+
+// `rows` x `cols`, holding 0, 1, 2 ... row after row.
+Matrix<int> counting(unsigned rows, unsigned cols)
+{
+	Matrix<int> m{rows, cols};
+	for (unsigned i = 0; i < rows; ++i)
+		for (unsigned j = 0; j < cols; ++j)
+			m.set(i, j, int(i * cols + j));
+	return m;
+}
+
+bool equal(Matrix<int> const& a, Matrix<int> const& b)
+{
+	if (a.getRows() != b.getRows() || a.getCols() != b.getCols())
+		return false;
+	for (unsigned i = 0; i < a.getRows(); ++i)
+		for (unsigned j = 0; j < a.getCols(); ++j)
+			if (a.at(i, j) != b.at(i, j)) return false;
+	return true;
+}
+
+int main()
+{
+	{
+		Matrix<int> a = counting(3, 3);
+		Matrix<int> expected{a.transposed()};
+		a = a.transposed();
+		expect(equal(a, expected), "A = A.transposed()");
+	}
+	{
+		Matrix<int> a = counting(3, 3);
+		Matrix<int> expected{a.transposed() + a};
+		a = a.transposed() + a;
+		expect(equal(a, expected), "A = A.transposed() + A");
+	}
+	{
+		Matrix<int> a = counting(4, 5);
+		Matrix<int> expected{a.block(1, 2, 3, 2)};
+		a = a.block(1, 2, 3, 2);
+		expect(equal(a, expected), "A = A.block(...)");
+	}
+	{
+		// Element-wise: computed in place, without a new block.
+		Matrix<int> a = counting(3, 4);
+		Matrix<int> expected{a * 2 + a};
+		int const* storage = a.getData();
+		a = a * 2 + a;
+		expect(equal(a, expected), "A = A * 2 + A");
+		expect(a.getData() == storage, "A = A * 2 + A reuses the memory");
+	}
+	{
+		// Another matrix of the same size: in place as well.
+		Matrix<int> a = counting(3, 3), b = counting(3, 3);
+		int const* storage = a.getData();
+		a = b.transposed();
+		expect(equal(a, counting(3, 3).transposed()), "A = B.transposed()");
+		expect(a.getData() == storage, "A = B.transposed() reuses the memory");
+	}
+	return report();
+}
@@ -0,0 +1,73 @@
+#include "../MatrixOperations.h"
+#include "Check.h"
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+
+/*
+ * Not a benchmark, but a check: the parallel operations of
+ * MatrixOperations.h give exactly the same bits as the serial ones, on any
+ * number of threads - also after ThreadPool::resize().
+ *
+ *     g++ -std=c++17 -O2 -pthread ParallelMatrix.c++ -o parallel
+ *
+ * The elements are doubles of all magnitudes, so that a sum in another
+ * order would round differently.
+ */
+
+using namespace std;
+
+Matrix<double> randomMatrix(unsigned rows, unsigned cols)
+{
+	Matrix<double> m{rows, cols};
+	for (unsigned i = 0; i < rows; ++i)
+		for (unsigned j = 0; j < cols; ++j)
+			m.set(i, j, (rand() - RAND_MAX / 2) * 1e-3 / (1 + rand() % 1000));
+	return m;
+}
+
+bool sameBits(Matrix<double> const& a, Matrix<double> const& b)
+{
+	if (a.getRows() != b.getRows() || a.getCols() != b.getCols())
+		return false;
+	for (unsigned i = 0; i < a.getRows(); ++i)
+		if (memcmp(a.row(i), b.row(i), a.getCols() * sizeof(double)))
+			return false;
+	return true;
+}
+
+bool sameBits(double a, double b) { return memcmp(&a, &b, sizeof a) == 0; }
+
+int main()
+{
+	srand(42);
+	Matrix<double> a = randomMatrix(203, 157), b = randomMatrix(203, 157);
+	Matrix<double> c = randomMatrix(157, 91);
+	auto square = [](double x) { return x * x; };
+
+	ThreadPool pool{0};
+	for (unsigned workers : {0u, 1u, 3u, 7u, 2u}) {
+		pool.resize(workers);
+
+		expect(sameBits(map(a, square, pool), map(a, square)), "map");
+		expect(sameBits(add(a, b, pool), add(a, b)), "add");
+		expect(sameBits(scale(a, 0.3, pool), scale(a, 0.3)), "scale");
+		expect(sameBits(transpose(a, pool), transpose(a)), "transpose");
+		expect(sameBits(multiply(a, c, pool), multiply(a, c)), "multiply");
+		expect(sameBits(sum(a, pool), sum(a)), "sum");
+		expect(sameBits(min(a, pool), min(a)), "min");
+		expect(sameBits(max(a, pool), max(a)), "max");
+		expect(sameBits(normMax(a, pool), normMax(a)), "normMax");
+		expect(sameBits(normFrobenius(a, pool), normFrobenius(a)),
+		       "normFrobenius");
+
+		// Every task runs once, and parallelFor() returns only when all
+		// have - also for workers started by resize().
+		for (unsigned k = 0; k < 100; ++k) {
+			atomic<unsigned> calls{0};
+			pool.parallelFor(64, [&](unsigned) { calls++; });
+			expect(calls == 64, "parallelFor after resize()");
+		}
+	}
+	return report();
+}
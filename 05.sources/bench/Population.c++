@@ -0,0 +1,101 @@
+#include "../City.h"
+#include "../Population.h"
+#include "Benchmark.h"
+#include "Fixtures.h"
+#include <string>
+
+/*
+ * "Is anyone sick around here?" queries which check everyone, on the people
+ * stored as an array of Person ("aos") and as a Population ("soa", once with
+ * each SimdLevel).
+ *
+ *     g++ -std=c++17 -O2 Population.c++ ../Person.c++ -o population
+ *
+ * Everyone is checked, so "ops_per_s" is people checked per second. The
+ * "far" queries are outside the square, so no query stops early. The "near"
+ * ones are where people are: half of them at a sick person, so they stop at
+ * the first sick person near, half at a healthy one, mostly scanning all.
+ *
+ * NOTE: Before timing, every near query is answered by the aos scan, by
+ * City::hasSickPeopleAround() (the grid) and by the soa kernels; if any
+ * answer differs, the program says so and fails.
+ */
+
+using namespace std;
+
+const unsigned WARMUPS = 3;
+const unsigned SAMPLES = 21;
+const unsigned QUERIES = 16;
+const float RADIUS = 10;
+
+int main()
+{
+	const char* levelNames[] = {"scalar", "sse", "avx2"};
+	SimdLevel levels[] = {SimdLevel::SCALAR, SimdLevel::SSE, SimdLevel::AVX2};
+
+	for (unsigned n : {1000u, 10000u, 100000u, 1000000u}) {
+		City city;
+		Population population;
+		unsigned side = sideFor(n);
+		populate(city, n, side);
+		for (unsigned i = 0; i < n; ++i)
+			population.push(city.people[i].loc, city.people[i].healthState);
+
+		// Outside the square, so nobody is near.
+		Position far[QUERIES];
+		for (unsigned q = 0; q < QUERIES; ++q)
+			far[q] = Position{-100, -100, 0};
+
+		// At people outside, spread over the array: a sick person for the
+		// even queries, a healthy one for the odd.
+		auto wanted = [](Person& person, bool sick) {
+			return !person.loc.checkIfHome() &&
+			       (person.healthState.healthState == HealthState::ILL) == sick;
+		};
+		Position near[QUERIES];
+		for (unsigned q = 0; q < QUERIES; ++q) {
+			unsigned i = q * (n / QUERIES);
+			while (!wanted(city.people[i], q % 2 == 0))
+				i = (i + 1) % n;
+			near[q] = city.people[i].loc.getPosition();
+		}
+
+		for (unsigned q = 0; q < QUERIES; ++q) {
+			bool expected = scanForSick(city, near[q], RADIUS);
+			bool same = city.hasSickPeopleAround(near[q], RADIUS) == expected;
+			for (unsigned l = 0; l < 3; ++l)
+				if (levels[l] <= detectSimdLevel())
+					same = same && population.hasSickPeopleAround(
+					                   near[q], RADIUS, levels[l]) == expected;
+			if (!same) {
+				std::fprintf(stderr, "%u people, query %u: the answers "
+				                     "differ\n",
+				             n, q);
+				return 1;
+			}
+		}
+
+		for (auto queries : {make_pair("far", far), make_pair("near", near)}) {
+			Position const* at = queries.second;
+			string name = string("hasSickPeopleAround/") + queries.first;
+
+			printJson((name + "/aos").c_str(), n, n * QUERIES,
+			          measure(WARMUPS, SAMPLES, [] {}, [&] {
+				          for (unsigned q = 0; q < QUERIES; ++q)
+					          doNotOptimize(scanForSick(city, at[q], RADIUS));
+			          }));
+
+			for (unsigned l = 0; l < 3; ++l) {
+				if (levels[l] > detectSimdLevel()) continue;
+
+				printJson((name + "/soa/" + levelNames[l]).c_str(), n,
+				          n * QUERIES, measure(WARMUPS, SAMPLES, [] {}, [&] {
+					          for (unsigned q = 0; q < QUERIES; ++q)
+						          doNotOptimize(population.hasSickPeopleAround(
+						              at[q], RADIUS, levels[l]));
+				          }));
+			}
+		}
+	}
+	return 0;
+}
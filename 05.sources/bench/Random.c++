@@ -0,0 +1,84 @@
+#include "../Random.h"
+#include "../ThreadPool.h"
+#include "Benchmark.h"
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+/*
+ * Random floats in [0, 1) per second: from the C rand(), and from the
+ * generators of Random.h - on one thread, and on every core at once.
+ *
+ *     g++ -std=c++17 -O2 -pthread Random.c++ -o random
+ *
+ * "RandomStream/per_draw" makes a new stream for every number, like
+ * City::update() does for every person and tick - the worst case.
+ * On several threads, rand() is shared by all of them (glibc takes a lock
+ * on every call); the others have one generator per thread.
+ */
+
+using namespace std;
+
+const unsigned WARMUPS = 1;
+const unsigned SAMPLES = 11;
+const unsigned DRAWS = 1 << 22;
+
+// The sum keeps the optimizer from dropping the draws.
+template <typename Draw> float sumOf(unsigned count, Draw draw)
+{
+	float sum = 0;
+	for (unsigned i = 0; i < count; ++i)
+		sum += draw(i);
+	return sum;
+}
+
+template <typename Draws> void run(const char* name, Draws draws)
+{
+	printJson(name, DRAWS, DRAWS, measure(WARMUPS, SAMPLES, [] {}, [&] {
+		          doNotOptimize(draws(0, DRAWS));
+	          }));
+}
+
+int main()
+{
+	auto crand = [](unsigned, unsigned count) {
+		return sumOf(count,
+		             [](unsigned) { return rand() / (RAND_MAX + 1.0f); });
+	};
+	auto stream = [](unsigned thread, unsigned count) {
+		RandomStream random{42, thread};
+		return sumOf(count, [&](unsigned) { return uniform(random); });
+	};
+	auto perDraw = [](unsigned thread, unsigned count) {
+		return sumOf(count, [&](unsigned i) {
+			RandomStream random{42, (std::uint64_t(thread) << 32) | i};
+			return uniform(random);
+		});
+	};
+	auto xoshiro = [](unsigned thread, unsigned count) {
+		Xoshiro256 random = Xoshiro256::stream(42, thread);
+		return sumOf(count, [&](unsigned) { return uniform(random); });
+	};
+
+	run("rand", crand);
+	run("RandomStream", stream);
+	run("RandomStream/per_draw", perDraw);
+	run("Xoshiro256", xoshiro);
+
+	unsigned cores = std::thread::hardware_concurrency();
+	if (cores < 2) return 0;
+
+	ThreadPool pool{cores - 1};
+	auto parallel = [&](auto draws) {
+		return [&pool, cores, draws](unsigned, unsigned count) {
+			pool.parallelFor(cores, [&](unsigned thread) {
+				doNotOptimize(draws(thread, count / cores));
+			});
+			return 0.0f;
+		};
+	};
+	run("rand/all_cores", parallel(crand));
+	run("RandomStream/all_cores", parallel(stream));
+	run("Xoshiro256/all_cores", parallel(xoshiro));
+	return 0;
+}
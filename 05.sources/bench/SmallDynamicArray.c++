@@ -0,0 +1,110 @@
+#include "../SmallDynamicArray.h"
+#include "Check.h"
+#include <string>
+
+/*
+ * Not a benchmark, but a check: a SmallDynamicArray keeps its elements
+ * across the inline -> heap boundary and back - growing past N, copying,
+ * moving and shrinking, with inline and with heap elements. Strings own
+ * memory, so a lost or doubly destroyed element shows up under
+ * -fsanitize=address.
+ *
+ *     g++ -std=c++17 -O2 SmallDynamicArray.c++ -o small
+ */
+
+using namespace std;
+
+const unsigned N = 4;
+using Array = SmallDynamicArray<string, N>;
+
+// A string too long for the small-string optimization of std::string.
+string text(unsigned i)
+{
+	return "element number " + to_string(i) + " of the array under test";
+}
+
+// Whether `array` holds text(0), text(1) ... text(size - 1).
+bool holds(Array const& array, unsigned size)
+{
+	if (array.getSize() != size) return false;
+	for (unsigned i = 0; i < size; ++i)
+		if (array[i] != text(i)) return false;
+	return true;
+}
+
+Array counting(unsigned size)
+{
+	Array array;
+	for (unsigned i = 0; i < size; ++i)
+		array.push(text(i));
+	return array;
+}
+
+int main()
+{
+	// Growing: inline up to N, then on the heap.
+	Array array;
+	for (unsigned i = 0; i < N; ++i)
+		array.push(text(i));
+	expect(holds(array, N) && array.capacity() == N, "N elements inline");
+	array.push(text(N));
+	expect(holds(array, N + 1) && array.capacity() > N, "N + 1 on the heap");
+
+	// NOTE: push() of an element of the array itself, while it reallocates.
+	Array full = counting(N);
+	full.push(full[0]);
+	expect(full.getSize() == N + 1 && full[N] == text(0),
+	       "push() of an own element");
+
+	// Copies, both ways.
+	Array heapCopy{array};
+	expect(holds(heapCopy, N + 1) && holds(array, N + 1), "copy of a heap one");
+	Array inlineCopy{counting(2)};
+	inlineCopy = counting(3);
+	expect(holds(inlineCopy, 3) && inlineCopy.capacity() == N,
+	       "copy of an inline one");
+	inlineCopy = heapCopy;
+	expect(holds(inlineCopy, N + 1), "heap one assigned to an inline one");
+	heapCopy = counting(1);
+	expect(holds(heapCopy, 1), "inline one assigned to a heap one");
+
+	// Moves: heap elements are taken over, inline ones moved one by one.
+	Array movedHeap{std::move(array)};
+	expect(holds(movedHeap, N + 1) && array.getSize() == 0,
+	       "move of a heap one");
+	array = counting(N + 3);
+	Array movedInline = counting(2);
+	movedInline = std::move(array);
+	expect(holds(movedInline, N + 3), "heap one moved over an inline one");
+	movedInline = counting(N);
+	expect(holds(movedInline, N) && movedInline.capacity() == N,
+	       "inline one moved over a heap one");
+
+	// Self-extension across the boundary.
+	Array doubled = counting(N - 1);
+	doubled.extendWith(doubled);
+	expect(doubled.getSize() == 2 * (N - 1) && doubled[N - 1] == text(0),
+	       "extendWith() itself");
+
+	// Shrinking back: the heap block is released when they fit inline.
+	Array shrinking = counting(3 * N);
+	shrinking.deleteRange(N + 1, 2 * N - 1);
+	shrinking.shrink_to_fit();
+	expect(holds(shrinking, N + 1) && shrinking.capacity() == N + 1,
+	       "shrink_to_fit() on the heap");
+	shrinking.deleteAt(N);
+	shrinking.shrink_to_fit();
+	expect(holds(shrinking, N) && shrinking.capacity() == N,
+	       "shrink_to_fit() back inline");
+	shrinking.push(text(N));
+	expect(holds(shrinking, N + 1), "growing again after shrinking");
+
+	unsigned removed = shrinking.eraseIf([](string const& s) {
+		return s != text(0) && s != text(1);
+	});
+	shrinking.shrink_to_fit();
+	expect(removed == N - 1 && holds(shrinking, 2) &&
+	           shrinking.capacity() == N,
+	       "eraseIf() and shrink_to_fit() back inline");
+	return report();
+}
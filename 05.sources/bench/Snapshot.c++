@@ -0,0 +1,91 @@
+#include "../City.h"
+#include "../Snapshot.h"
+#include "Benchmark.h"
+#include "Fixtures.h"
+#include <cstdio>
+
+/*
+ * What streaming the snapshots costs the simulation thread: TICKS ticks of
+ * City::update() alone, and with SnapshotWriter::write() after every tick.
+ * Then the stream is replayed with SnapshotReader, which must end up with
+ * the same people as the city - if not, the program says so and fails.
+ *
+ *     g++ -std=c++17 -O2 -pthread Snapshot.c++ ../Person.c++ -o snapshot
+ *
+ * Also prints the average size of a frame, in bytes per person.
+ */
+
+using namespace std;
+
+const unsigned WARMUPS = 1;
+const unsigned SAMPLES = 5;
+const unsigned TICKS = 10;
+const char* const PATH = "snapshot-bench.snap";
+
+bool sameAsReplay(City& city)
+{
+	SnapshotReader reader{PATH};
+	while (reader.next()) {
+	}
+
+	if (reader.getSize() != city.people.getSize()) return false;
+	for (unsigned i = 0; i < reader.getSize(); ++i) {
+		Person& person = city.people[i];
+		if (reader.checkIfHome(i) != person.loc.checkIfHome()) return false;
+		if (reader.getHealth(i) != person.healthState.healthState) return false;
+		if (person.loc.checkIfHome()) continue;
+
+		Position a = reader.getPosition(i), b = person.loc.getPosition();
+		if (a.x != b.x || a.y != b.y) return false;
+	}
+	return true;
+}
+
+int main()
+{
+	for (unsigned n : {10000u, 100000u, 1000000u}) {
+		City city;
+
+		auto reset = [&] { populate(city, n, sideFor(n)); };
+		printJson("City::update", n, double(n) * TICKS,
+		          measure(WARMUPS, SAMPLES, reset, [&] {
+			          for (unsigned t = 0; t < TICKS; ++t)
+				          city.update(1);
+		          }));
+
+		// NOTE: The writer is made in the setup, so opening the file isn't
+		// measured; closing it (waiting for the disk) isn't either.
+		SnapshotWriter* writer = nullptr;
+		auto setup = [&] {
+			if (writer) writer->close();
+			delete writer;
+			reset();
+			writer = new SnapshotWriter{PATH, 64};
+		};
+		printJson("City::update+SnapshotWriter::write", n, double(n) * TICKS,
+		          measure(WARMUPS, SAMPLES, setup, [&] {
+			          for (unsigned t = 0; t < TICKS; ++t) {
+				          city.update(1);
+				          writer->write(city);
+			          }
+		          }));
+		writer->close();
+		unsigned frames = TICKS - writer->getDropped();
+		delete writer;
+
+		std::FILE* file = std::fopen(PATH, "rb");
+		std::fseek(file, 0, SEEK_END);
+		long bytes = std::ftell(file) - long(sizeof(SnapshotHeader));
+		std::fclose(file);
+		std::printf("{\"name\": \"snapshot/bytes_per_person\", \"size\": %u, "
+		            "\"frames\": %u, \"value\": %.3g}\n",
+		            n, frames, double(bytes) / frames / n);
+
+		if (!sameAsReplay(city)) {
+			std::fprintf(stderr, "%u people: the replay differs\n", n);
+			return 1;
+		}
+	}
+	std::remove(PATH);
+	return 0;
+}
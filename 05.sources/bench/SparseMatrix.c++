@@ -0,0 +1,101 @@
+#include "../MatrixMultiply.h"
+#include "../SparseMatrix.h"
+#include "Check.h"
+#include <random>
+
+/*
+ * Not a benchmark, but a check: a SparseMatrix built from entries in any
+ * order, some of them repeated, is the same matrix as the dense one made
+ * from the same entries, and multiplies a vector the same. The elements are
+ * ints, so "the same" means equal.
+ *
+ *     g++ -std=c++17 -O2 -pthread SparseMatrix.c++ -o sparse
+ */
+
+using namespace std;
+
+// Adds `value` at (row, col) to both the builder and the dense matrix.
+void add(SparseMatrixBuilder<int>& sparse, Matrix<int>& dense, unsigned row,
+         unsigned col, int value)
+{
+	sparse.add(row, col, value);
+	dense.set(row, col, dense.get(row, col) + value);
+}
+
+bool equal(SparseMatrix<int> const& sparse, Matrix<int> const& dense)
+{
+	if (sparse.getRows() != dense.getRows() ||
+	    sparse.getCols() != dense.getCols())
+		return false;
+	for (unsigned i = 0; i < dense.getRows(); ++i)
+		for (unsigned j = 0; j < dense.getCols(); ++j)
+			if (sparse.get(i, j) != dense.get(i, j)) return false;
+	return true;
+}
+
+// sparse * x against the dense product with x as a column.
+bool multipliesLike(SparseMatrix<int> const& sparse, Matrix<int> const& dense,
+                    ThreadPool* pool)
+{
+	unsigned cols = dense.getCols();
+	DynamicArray<int> x(cols);
+	Matrix<int> column{cols, 1};
+	for (unsigned j = 0; j < cols; ++j) {
+		x[j] = int(j % 7) - 3;
+		column.set(j, 0, x[j]);
+	}
+
+	DynamicArray<int> y = sparse.multiply(x, pool);
+	Matrix<int> expected = multiplyNaive(dense, column);
+	for (unsigned i = 0; i < dense.getRows(); ++i)
+		if (y[i] != expected.get(i, 0)) return false;
+	return true;
+}
+
+int main()
+{
+	{
+		// Small enough to follow by hand: rows out of order, columns out
+		// of order within a row, (1, 2) three times, an empty row 2.
+		SparseMatrixBuilder<int> builder{4, 5};
+		Matrix<int> dense{4, 5};
+		add(builder, dense, 3, 4, 9);
+		add(builder, dense, 1, 2, 1);
+		add(builder, dense, 0, 3, 5);
+		add(builder, dense, 1, 0, 2);
+		add(builder, dense, 1, 2, 1);
+		add(builder, dense, 3, 0, -4);
+		add(builder, dense, 1, 2, 1);
+
+		SparseMatrix<int> sparse = builder.build();
+		expect(sparse.getNonZeros() == 5, "duplicates are merged");
+		expect(sparse.get(1, 2) == 3, "duplicates are summed");
+		expect(equal(sparse, dense), "small: the same elements");
+		expect(equal(SparseMatrix<int>::fromDense(dense), dense),
+		       "small: fromDense");
+		expect(multipliesLike(sparse, dense, nullptr), "small: multiply");
+	}
+	{
+		// More rows than a block of multiply(), so the pool splits them.
+		const unsigned ROWS = 10000, COLS = 300;
+		minstd_rand random{42};
+		SparseMatrixBuilder<int> builder{ROWS, COLS};
+		Matrix<int> dense{ROWS, COLS};
+		for (unsigned k = 0; k < 20 * ROWS; ++k)
+			add(builder, dense, random() % ROWS, random() % 16 * 17 % COLS,
+			    int(random() % 19) - 9);
+
+		SparseMatrix<int> sparse = builder.build();
+		expect(equal(sparse, dense), "large: the same elements");
+		expect(multipliesLike(sparse, dense, nullptr), "large: multiply");
+
+		ThreadPool pool{3};
+		expect(multipliesLike(sparse, dense, &pool),
+		       "large: multiply with a pool");
+	}
+	expect(throws<runtime_error>([] {
+		       SparseMatrixBuilder<int>{2, 2}.add(2, 0, 1);
+	       }),
+	       "an entry out of range throws");
+	return report();
+}
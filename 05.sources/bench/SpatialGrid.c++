@@ -0,0 +1,65 @@
+#include "../City.h"
+#include "Benchmark.h"
+#include "Fixtures.h"
+
+/*
+ * How the infection check of one tick scales with the population: every
+ * person outside asks "is anyone sick around me?".
+ *
+ *     g++ -std=c++17 -O2 SpatialGrid.c++ ../Person.c++ -o grid
+ *
+ * "scan" checks every person for every query, as City did before the grid -
+ * O(n^2) per tick, so it only runs for small cities. "grid" rebuilds the
+ * SpatialGrid and queries it - O(n) per tick: the people per second
+ * ("ops_per_s") should stay about the same as the city grows.
+ *
+ * The density is the same at every size (the city grows with the
+ * population), like in a real country: more people, more land.
+ */
+
+using namespace std;
+
+const unsigned WARMUPS = 1;
+const unsigned SAMPLES = 5;
+const unsigned SCAN_LIMIT = 20000;
+
+template <typename Check> unsigned checkEveryone(City& city, Check check)
+{
+	unsigned exposed = 0;
+	for (unsigned i = 0; i < city.people.getSize(); ++i) {
+		Person& person = city.people[i];
+		if (person.loc.checkIfHome()) continue;
+		exposed += check(person.loc.getPosition());
+	}
+	return exposed;
+}
+
+int main()
+{
+	for (unsigned n : {1000u, 10000u, 20000u, 100000u, 1000000u, 4000000u}) {
+		City city;
+		populate(city, n, sideFor(n));
+
+		if (n <= SCAN_LIMIT)
+			printJson("tick/scan", n, n,
+			          measure(WARMUPS, SAMPLES, [] {}, [&] {
+				          doNotOptimize(checkEveryone(city, [&](Position p) {
+					          return scanForSick(city, p, 10);
+				          }));
+			          }));
+
+		printJson("tick/grid", n, n, measure(WARMUPS, SAMPLES, [] {}, [&] {
+			          city.rebuildIndex();
+			          doNotOptimize(checkEveryone(city, [&](Position p) {
+				          return city.hasSickPeopleAround(p, 10);
+			          }));
+		          }));
+
+		// NOTE: update() moves people, so every run starts from scratch.
+		printJson("City::update", n, n,
+		          measure(WARMUPS, SAMPLES,
+		                  [&] { populate(city, n, sideFor(n)); },
+		                  [&] { city.update(1); }));
+	}
+	return 0;
+}
@@ -0,0 +1,142 @@
+#include "../City.h"
+#include "../DynamicArray.h"
+#include "../Matrix.h"
+#include "../Person.h"
+#include "../Position.h"
+#include "Benchmark.h"
+#include "Fixtures.h"
+#include <cstdlib>
+#include <cstring>
+
+/*
+ * Micro-benchmarks of the core containers and of the simulation, for
+ * comparing runs before and after a change:
+ *
+ *     g++ -std=c++17 -O2 Suite.c++ ../Person.c++ -o suite
+ *     ./suite > before.jsonl
+ *     ./suite City > city.jsonl   # only the benchmarks whose name has "City"
+ *
+ * Every case is warmed up, then timed SAMPLES times; one JSON line per case
+ * and input size is printed (see printJson()).
+ */
+
+using namespace std;
+
+const unsigned WARMUPS = 3;
+const unsigned SAMPLES = 31;
+
+const char* filter = nullptr;
+
+template <typename Setup, typename F>
+void bench(const char* name, unsigned size, double operations, Setup setup,
+           F f)
+{
+	if (filter && !strstr(name, filter)) return;
+	printJson(name, size, operations, measure(WARMUPS, SAMPLES, setup, f));
+}
+
+// Positions in a 1000 x 1000 square, the same ones on every run.
+Position randomPosition()
+{
+	return Position{float(rand() % 1000), float(rand() % 1000),
+	                float(rand() % 628) / 100};
+}
+
+// ---- DynamicArray ---------------------------------------------------------
+
+void benchDynamicArray(unsigned n)
+{
+	DynamicArray<Position> array, filled;
+	for (unsigned i = 0; i < n; ++i)
+		filled.push(Position{float(i), float(i), 0});
+
+	bench("DynamicArray::push", n, n, [&] { array = DynamicArray<Position>{}; },
+	      [&] {
+		      for (unsigned i = 0; i < n; ++i)
+			      array.push(Position{float(i), float(i), 0});
+	      });
+
+	// Each removal from the middle shifts half of the elements.
+	const unsigned DELETES = 100;
+	bench("DynamicArray::deleteAt", n, DELETES, [&] { array = filled; },
+	      [&] {
+		      for (unsigned i = 0; i < DELETES; ++i)
+			      array.deleteAt(array.getSize() / 2);
+	      });
+
+	bench("DynamicArray::operator[]", n, n, [] {}, [&] {
+		float sum = 0;
+		for (unsigned i = 0; i < n; ++i)
+			sum += filled[i].x;
+		doNotOptimize(sum);
+	});
+
+	doNotOptimize(array);
+}
+
+// ---- Matrix ---------------------------------------------------------------
+
+void benchMatrix(unsigned side)
+{
+	Matrix<float> matrix{side, side};
+	double cells = double(side) * side;
+
+	bench("Matrix::set", side, cells, [] {}, [&] {
+		for (unsigned i = 0; i < side; ++i)
+			for (unsigned j = 0; j < side; ++j)
+				matrix.set(i, j, float(i + j));
+	});
+
+	bench("Matrix::get", side, cells, [] {}, [&] {
+		float sum = 0;
+		for (unsigned i = 0; i < side; ++i)
+			for (unsigned j = 0; j < side; ++j)
+				sum += matrix.get(i, j);
+		doNotOptimize(sum);
+	});
+
+	Matrix<float> growing;
+	bench("Matrix::addRow", side, side,
+	      [&] { growing = Matrix<float>{0, side}; },
+	      [&] {
+		      for (unsigned i = 0; i < side; ++i)
+			      growing.addRow();
+	      });
+}
+
+// ---- City -----------------------------------------------------------------
+
+void benchCity(unsigned n)
+{
+	City city;
+
+	// NOTE: update() changes the people, so every run starts from the same
+	// population.
+	bench("City::update", n, n, [&] { populate(city, n, 1000); },
+	      [&] { city.update(1); });
+
+	const unsigned QUERIES = 100;
+	populate(city, n, 1000);
+	bench("City::hasSickPeopleAround", n, QUERIES, [] { srand(7); }, [&] {
+		unsigned found = 0;
+		for (unsigned i = 0; i < QUERIES; ++i)
+			found += city.hasSickPeopleAround(randomPosition(), 10);
+		doNotOptimize(found);
+	});
+}
+
+int main(int argc, char** argv)
+{
+	if (argc > 1) filter = argv[1];
+
+	for (unsigned n : {1000u, 10000u, 100000u, 1000000u})
+		benchDynamicArray(n);
+
+	for (unsigned side : {64u, 256u, 1024u})
+		benchMatrix(side);
+
+	for (unsigned n : {1000u, 10000u, 100000u})
+		benchCity(n);
+
+	return 0;
+}
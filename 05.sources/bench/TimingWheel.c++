@@ -0,0 +1,72 @@
+#include "../Person.h"
+#include "../TimingWheel.h"
+#include "Benchmark.h"
+
+/*
+ * The health transitions of TICKS ticks, for a population of which 1% is
+ * ill (infected at different times):
+ *
+ *  - "health/scan" looks at every person every tick, as
+ *    HealthState::update() did;
+ *  - "health/wheel" fires the events of a TimingWheel, as City does.
+ *
+ *     g++ -std=c++17 -O2 TimingWheel.c++ -o wheel
+ *
+ * "ops_per_s" is people per second: the scan should be about the same at
+ * any size, and the wheel about 100 times faster (it only looks at the ill).
+ */
+
+using namespace std;
+
+const unsigned WARMUPS = 1;
+const unsigned SAMPLES = 11;
+const unsigned TICKS = HealthState::INCUBATION + HealthState::ILLNESS;
+
+// 1% ill, infected over the last TICKS ticks.
+void populate(DynamicArray<HealthState>& people, unsigned n)
+{
+	people = DynamicArray<HealthState>{};
+	people.reserve(n);
+	for (unsigned i = 0; i < n; ++i) {
+		HealthState health{0, false, HealthState::HEALTHY, 0};
+		if (i % 100 == 1) health.infect(TICKS - i / 100 % TICKS);
+		people.push(health);
+	}
+}
+
+int main()
+{
+	for (unsigned n : {10000u, 100000u, 1000000u, 10000000u}) {
+		DynamicArray<HealthState> people;
+
+		printJson("health/scan", n, double(n) * TICKS,
+		          measure(WARMUPS, SAMPLES, [&] { populate(people, n); }, [&] {
+			          for (unsigned now = TICKS + 1; now <= 2 * TICKS; ++now)
+				          for (unsigned i = 0; i < people.getSize(); ++i) {
+					          HealthState& health = people[i];
+					          if (health.healthState == HealthState::ILL &&
+					              health.nextChange == now)
+						          health.advance();
+				          }
+		          }));
+
+		TimingWheel<unsigned> wheel{32};
+		auto setup = [&] {
+			populate(people, n);
+			wheel.clear(TICKS);
+			for (unsigned i = 0; i < people.getSize(); ++i)
+				if (people[i].healthState == HealthState::ILL)
+					wheel.schedule(people[i].nextChange, i);
+		};
+		printJson("health/wheel", n, double(n) * TICKS,
+		          measure(WARMUPS, SAMPLES, setup, [&] {
+			          wheel.advanceTo(2 * TICKS, [&](unsigned, unsigned i) {
+				          HealthState& health = people[i];
+				          health.advance();
+				          if (health.healthState == HealthState::ILL)
+					          wheel.schedule(health.nextChange, i);
+			          });
+		          }));
+	}
+	return 0;
+}
@@ -0,0 +1,67 @@
+#include "../World.h"
+#include "Benchmark.h"
+#include "Fixtures.h"
+#include <cstdio>
+
+/*
+ * World::update() of a country - CITIES cities of PEOPLE people each - on
+ * 1, 2 and 4 threads: the time of TICKS ticks, and whether the world ends
+ * up in exactly the same state on every number of threads. If it doesn't,
+ * the program says so and fails.
+ *
+ * NOTE: All three also on fewer cores, as in CityUpdate.c++.
+ *
+ *     g++ -std=c++17 -O2 -pthread World.c++ ../Person.c++ -o world
+ */
+
+using namespace std;
+
+const unsigned WARMUPS = 1;
+const unsigned SAMPLES = 5;
+const unsigned TICKS = 10;
+const unsigned CITIES = 300;
+const unsigned PEOPLE = 3000;
+
+// PEOPLE people per city, each city with its own seed for rand().
+void populate(World& world)
+{
+	for (unsigned c = 0; c < world.getSize(); ++c)
+		populate(world[c], PEOPLE, sideFor(PEOPLE), 42 + c);
+}
+
+unsigned long long fingerprint(World& world)
+{
+	unsigned long long hash = fingerprint(world[0]);
+	for (unsigned c = 1; c < world.getSize(); ++c)
+		hash = fingerprint(world[c], hash);
+	return hash;
+}
+
+int main()
+{
+	unsigned long long expected = 0;
+	for (unsigned threads : {1u, 2u, 4u}) {
+		// The calling thread works too.
+		ThreadPool pool{threads - 1};
+		World world{CITIES, 42};
+		world.pool = &pool;
+
+		char name[64];
+		std::snprintf(name, sizeof name, "World::update/threads=%u", threads);
+		printJson(name, CITIES * PEOPLE, double(CITIES) * PEOPLE * TICKS,
+		          measure(WARMUPS, SAMPLES, [&] { populate(world); }, [&] {
+			          for (unsigned t = 0; t < TICKS; ++t)
+				          world.update(1);
+		          }));
+
+		unsigned long long hash = fingerprint(world);
+		if (threads == 1) expected = hash;
+		if (hash != expected) {
+			std::fprintf(stderr, "%u threads: the result differs from 1 "
+			                     "thread\n",
+			             threads);
+			return 1;
+		}
+	}
+	return 0;
+}
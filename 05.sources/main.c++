@@ -16,9 +16,12 @@ int main()
 	city.hasSickPeopleAround(loc.getPosition(), 10);
 	loc.move(10);
 
-	Person x{city, loc, HealthState::ILL};
+	HealthState ill{0, false, HealthState::HEALTHY, 0};
+	ill.infect(0);
+	Person x{city, loc, ill};
 
-	x.update(10);
+	RandomStream random{city.seed, 0};
+	x.update(random);
 
 	return 0;
 }